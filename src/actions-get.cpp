@@ -1,19 +1,24 @@
 #include "actions-get.h"
+#include "message-bus.h"
+#include "metrics.h"
 #include "cxxtools/jsonserializer.h"
 #include <fty/rest/component.h>
 #include <fty_common_asset_types.h>
 #include <fty_common_dto.h>
-#include <fty_common_messagebus.h>
-#include <fty_common_mlm_utils.h>
 
 namespace fty::asset {
 
 unsigned ActionsGet::run()
 {
-    rest::User user(m_request);
+    static auto&     stats = metrics::endpoint("asset/actions/get");
+    metrics::Request measure(stats, m_reply);
+
+    metrics::Scope permissions(metrics::Phase::Permissions);
+    rest::User     user(m_request);
     if (auto ret = checkPermissions(user.profile(), m_permissions); !ret) {
         throw rest::Error(ret.error());
     }
+    permissions.stop();
 
     Expected<std::string> id = m_request.queryArg<std::string>("id");
     if (!id) {
@@ -23,9 +28,8 @@ unsigned ActionsGet::run()
         throw rest::errors::RequestParamBad("id", *id, "valid asset name"_tr);
     }
 
-    auto msgbus = std::unique_ptr<messagebus::MessageBus>(
-        messagebus::MlmMessageBus(MLM_ENDPOINT, messagebus::getClientId("tntnet")));
-    msgbus->connect();
+    metrics::Scope bus(metrics::Phase::Bus);
+    auto           msgbus = messageBus();
 
     dto::commands::GetCommandsQueryDto queryDto;
     queryDto.asset = *id;
@@ -36,6 +40,7 @@ unsigned ActionsGet::run()
     msgRequest.metaData()[messagebus::Message::SUBJECT]        = "GetCommands";
     msgRequest.userData() << queryDto;
     auto msgReply = msgbus->request("ETN.Q.IPMCORE.POWERACTION", msgRequest, 10);
+    bus.stop();
 
     if (msgReply.metaData()[messagebus::Message::STATUS] != "ok") {
         logError("Request to fty-nut-command failed.");
@@ -45,6 +50,7 @@ unsigned ActionsGet::run()
     dto::commands::GetCommandsReplyDto replyDto;
     msgReply.userData() >> replyDto;
 
+    metrics::Scope              serialization(metrics::Phase::Serialization);
     cxxtools::SerializationInfo replySi;
     replySi.setCategory(cxxtools::SerializationInfo::Category::Array);
 
@@ -1,21 +1,27 @@
 #include "actions-post.h"
+#include "message-bus.h"
+#include "metrics.h"
+#include "request-body.h"
 #include <asset/asset-db.h>
-#include <cxxtools/jsondeserializer.h>
 #include <fty/rest/audit-log.h>
 #include <fty/rest/component.h>
 #include <fty_commands_dto.h>
 #include <fty_common_asset_types.h>
-#include <fty_common_messagebus.h>
-#include <fty_common_mlm_utils.h>
 
 namespace fty::asset {
 
 unsigned ActionsPost::run()
 {
-    rest::User user(m_request);
+    static auto&     stats = metrics::endpoint("asset/actions/post");
+    metrics::Request measure(stats, m_reply);
+    measure.budget(1);
+
+    metrics::Scope permissions(metrics::Phase::Permissions);
+    rest::User     user(m_request);
     if (auto ret = checkPermissions(user.profile(), m_permissions); !ret) {
         throw rest::Error(ret.error());
     }
+    permissions.stop();
 
     Expected<std::string> id = m_request.queryArg<std::string>("id");
     if (!id) {
@@ -25,41 +31,58 @@ unsigned ActionsPost::run()
         throw rest::errors::RequestParamBad("id", *id, "valid asset name"_tr);
     }
 
-    auto item = db::nameToExtName(*id);
+    metrics::Scope dbScope(metrics::Phase::Db);
+    auto           item = [&]() {
+        metrics::DbCall call;
+        return db::nameToExtName(*id);
+    }();
+    dbScope.stop();
     if (!item) {
         throw rest::errors::Internal(item.error());
     }
 
-    auto msgbus = std::unique_ptr<messagebus::MessageBus>(
-        messagebus::MlmMessageBus(MLM_ENDPOINT, messagebus::getClientId("tntnet")));
-    msgbus->connect();
+    metrics::Scope bus(metrics::Phase::Bus);
+    auto           msgbus = messageBus();
 
-    // Read json, transform to command list
-    cxxtools::SerializationInfo            si;
+    // Read json straight into the command list
     dto::commands::PerformCommandsQueryDto commandList;
 
     try {
-        std::stringstream          input(m_request.body(), std::ios_base::in);
-        cxxtools::JsonDeserializer deserializer(input);
-        deserializer.deserialize(si);
-        if (si.category() != cxxtools::SerializationInfo::Category::Array) {
+        const auto& body = m_request.body();
+        JsonReader  reader(body);
+        if (!reader.atArray()) {
             throw std::runtime_error("expected array of objects");
         }
-
-        for (const auto& i : si) {
+        reader.enterArray();
+        while (reader.nextItem()) {
             dto::commands::Command command;
             command.asset = *id;
 
-            if (i.category() != cxxtools::SerializationInfo::Category::Object) {
+            if (!reader.atObject()) {
                 throw std::runtime_error("expected array of objects");
             }
-            if (!i.getMember("command", command.command)) {
+            reader.enterObject();
+
+            bool        hasCommand = false;
+            std::string key;
+            while (reader.nextMember(key)) {
+                if (key == "command") {
+                    command.command = reader.scalar();
+                    hasCommand      = true;
+                } else if (key == "target") {
+                    command.target = reader.scalar();
+                } else if (key == "argument") {
+                    command.argument = reader.scalar();
+                } else {
+                    reader.skip();
+                }
+            }
+            if (!hasCommand) {
                 throw std::runtime_error("expected command key in object");
             }
-            i.getMember("target", command.target);
-            i.getMember("argument", command.argument);
-            commandList.commands.push_back(command);
+            commandList.commands.push_back(std::move(command));
         }
+        reader.finish();
     } catch (const std::exception& e) {
         logError("Error while parsing document: {}", e.what());
         auditError("Request CREATE asset_actions asset {} FAILED", *item);
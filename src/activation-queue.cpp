@@ -0,0 +1,159 @@
+/*  ====================================================================================================================
+    activation-queue.cpp - Batched licensing activation of devices
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "activation-queue.h"
+#include "config.h"
+#include <asset/asset-helpers.h>
+#include <fty/rest/translate.h>
+#include <fty_common_asset.h>
+#include <fty_log.h>
+
+namespace fty::asset {
+
+struct ActivationQueue::Job
+{
+    FullAsset                asset;
+    std::promise<void>       promise;
+    std::shared_future<void> future = promise.get_future().share();
+};
+
+ActivationQueue& ActivationQueue::instance()
+{
+    static ActivationQueue queue;
+    return queue;
+}
+
+ActivationQueue::~ActivationQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+std::shared_future<void> ActivationQueue::push(const FullAsset& asset)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // the latest document of the asset is sent, it asks for the same operation
+    auto activate = asset.getStatusString() == "active";
+    for (auto it = m_pending.rbegin(); it != m_pending.rend(); ++it) {
+        if ((*it)->asset.getId() != asset.getId()) {
+            continue;
+        }
+        if (((*it)->asset.getStatusString() == "active") == activate) {
+            (*it)->asset = asset;
+            return (*it)->future;
+        }
+        break;
+    }
+
+    auto job   = std::make_shared<Job>();
+    job->asset = asset;
+
+    if (m_pending.size() >= MaxPending || m_stop) {
+        lock.unlock();
+        logDebug("Activation queue is full, activating {} in place", asset.getId());
+        process(*job);
+        return job->future;
+    }
+
+    m_pending.push_back(job);
+    try {
+        while (m_threads.size() < config::activationWorkers()) {
+            m_threads.emplace_back(&ActivationQueue::worker, this);
+        }
+    } catch (const std::exception& e) {
+        logWarn("Activation on {} thread(s) only: {}", m_threads.size(), e.what());
+    }
+    if (m_threads.empty()) {
+        m_pending.pop_back();
+        lock.unlock();
+        process(*job);
+        return job->future;
+    }
+    lock.unlock();
+
+    m_cond.notify_one();
+    return job->future;
+}
+
+// First waiting job whose asset is not being processed, under the lock
+std::shared_ptr<ActivationQueue::Job> ActivationQueue::take()
+{
+    for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
+        if (!m_running.count((*it)->asset.getId())) {
+            auto job = *it;
+            m_pending.erase(it);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void ActivationQueue::worker()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        std::shared_ptr<Job> job;
+        m_cond.wait(lock, [&]() {
+            job = take();
+            return job || (m_stop && m_pending.empty());
+        });
+        if (!job) {
+            return;
+        }
+
+        auto id = job->asset.getId();
+        m_running.insert(id);
+        lock.unlock();
+        process(*job);
+        lock.lock();
+        m_running.erase(id);
+
+        // the next request of the asset may wait for this one
+        m_cond.notify_all();
+    }
+}
+
+void ActivationQueue::process(Job& job)
+{
+    try {
+        if (job.asset.getStatusString() == "active") {
+            if (!activation::isActivable(job.asset)) {
+                throw std::runtime_error("Asset cannot be activated"_tr);
+            }
+            activation::activate(job.asset);
+        } else {
+            activation::deactivate(job.asset);
+        }
+        job.promise.set_value();
+    } catch (const std::exception& e) {
+        logError("Licensing activation of {} failed: {}", job.asset.getId(), e.what());
+        job.promise.set_exception(std::current_exception());
+    }
+}
+
+} // namespace fty::asset
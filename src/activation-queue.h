@@ -0,0 +1,74 @@
+/*  ====================================================================================================================
+    activation-queue.h - Batched licensing activation of devices
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fty {
+class FullAsset;
+}
+
+namespace fty::asset {
+
+/// Licensing (de)activation of devices, done in the background by FTY_ASSET_REST_ACTIVATION_WORKERS threads.
+/// Requests of different assets are processed in parallel, the ones of an asset one after the other, in the order they
+/// came. A request is collapsed with the last one waiting for the same asset only if both ask for the same operation:
+/// the callers share a result which is the one of their operation. Otherwise it is queued after it.
+/// Failures are logged by the workers, callers wanting them wait for the returned future.
+class ActivationQueue
+{
+public:
+    /// Maximum of waiting assets, when reached the request is done in the caller thread
+    static constexpr size_t MaxPending = 1024;
+
+    static ActivationQueue& instance();
+    ~ActivationQueue();
+
+    /// Queues activation (active status) or deactivation of the device.
+    /// The future is ready when request is done, holds licensing error if any.
+    std::shared_future<void> push(const FullAsset& asset);
+
+private:
+    struct Job;
+
+    ActivationQueue() = default;
+    void                 worker();
+    std::shared_ptr<Job> take();
+    static void          process(Job& job);
+
+private:
+    std::mutex                       m_mutex;
+    std::condition_variable          m_cond;
+    std::deque<std::shared_ptr<Job>> m_pending;
+    std::set<std::string>            m_running; // assets being processed
+    std::vector<std::thread>         m_threads;
+    bool                             m_stop = false;
+};
+
+} // namespace fty::asset
@@ -0,0 +1,126 @@
+/*  ====================================================================================================================
+    admission.cpp - Admission control of heavy requests
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "admission.h"
+#include "config.h"
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <fty_log.h>
+
+namespace fty::asset {
+
+Admission& Admission::instance()
+{
+    static Admission admission;
+    return admission;
+}
+
+double Admission::expectedWait(const Queue& queue) const
+{
+    // time for the requests running and waiting to be done
+    return queue.average * double(queue.running + queue.waiting.size()) / double(config::heavyLimit());
+}
+
+bool Admission::enter(Class kind)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto&                        queue = m_queues[size_t(kind)];
+
+    // no overtaking: a free place goes to the requests already waiting first
+    if (queue.waiting.empty() && queue.running < config::heavyLimit()) {
+        ++queue.running;
+        return true;
+    }
+    if (queue.waiting.size() >= config::heavyQueue()) {
+        return false;
+    }
+    if (expectedWait(queue) > std::chrono::duration<double>(config::heavyWait()).count()) {
+        return false;
+    }
+
+    uint64_t number = queue.next++;
+    queue.waiting.push_back(number);
+    bool turn = queue.free.wait_for(lock, config::heavyWait(), [&]() {
+        return queue.waiting.front() == number && queue.running < config::heavyLimit();
+    });
+
+    queue.waiting.erase(std::find(queue.waiting.begin(), queue.waiting.end(), number));
+    if (turn) {
+        ++queue.running;
+    }
+    // the next one may be at the front now, or may get the place given up
+    queue.free.notify_all();
+    return turn;
+}
+
+void Admission::leave(Class kind, std::chrono::steady_clock::duration duration)
+{
+    auto& queue = m_queues[size_t(kind)];
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --queue.running;
+        queue.average = 0.8 * queue.average + 0.2 * std::chrono::duration<double>(duration).count();
+    }
+    // only the first waiting request can take the place, it is not known which thread waits for it
+    queue.free.notify_all();
+}
+
+unsigned Admission::retryAfter(Class kind) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return unsigned(std::max(1., std::ceil(expectedWait(m_queues[size_t(kind)]))));
+}
+
+// =========================================================================================================================================
+
+Admission::Ticket::Ticket(Class kind)
+    : m_class(kind)
+{
+    metrics::Scope admission(metrics::Phase::Admission);
+    m_admitted = Admission::instance().enter(m_class);
+    // the average is the time a place is held, the wait for it would count twice in the expected wait
+    m_start = std::chrono::steady_clock::now();
+    if (!m_admitted) {
+        m_retryAfter = Admission::instance().retryAfter(m_class);
+        metrics::rejected();
+        logWarn("Heavy request turned away, retry in {}s", m_retryAfter);
+    }
+}
+
+Admission::Ticket::~Ticket()
+{
+    if (m_admitted) {
+        Admission::instance().leave(m_class, std::chrono::steady_clock::now() - m_start);
+    }
+}
+
+bool Admission::Ticket::admitted() const
+{
+    return m_admitted;
+}
+
+unsigned Admission::Ticket::retryAfter() const
+{
+    return m_retryAfter;
+}
+
+} // namespace fty::asset
@@ -0,0 +1,97 @@
+/*  ====================================================================================================================
+    admission.h - Admission control of heavy requests
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+namespace fty::asset {
+
+/// Limits the number of heavy requests (exports, imports, detailed listings, bulk deletes) running at once, so they
+/// cannot take all the web server workers and the database from the cheap ones.
+/// Each kind of heavy request has its own places and queue: detailed listings do not turn away an import. Requests over
+/// the limit wait in a bounded queue and get in in their order of arrival, the others are turned away to be retried
+/// later, at once when the wait is expected to be longer than allowed.
+class Admission
+{
+public:
+    enum class Class
+    {
+        Listing, // detailed listings
+        Export,
+        Import,
+        Delete, // bulk deletes
+        Count
+    };
+
+    /// Place of a heavy request, held until destroyed
+    class Ticket
+    {
+    public:
+        /// Waits for a place, see admitted()
+        explicit Ticket(Class kind);
+        ~Ticket();
+
+        Ticket(const Ticket&) = delete;
+        Ticket& operator=(const Ticket&) = delete;
+
+        /// False if the queue was full or the wait too long: answer 503 with retryAfter()
+        bool admitted() const;
+
+        /// Seconds after which a place is expected to be free
+        unsigned retryAfter() const;
+
+    private:
+        Class                                 m_class;
+        bool                                  m_admitted;
+        unsigned                              m_retryAfter = 0;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    static Admission& instance();
+
+private:
+    struct Queue
+    {
+        std::condition_variable free;
+        size_t                  running = 0;
+        std::deque<uint64_t>    waiting;     // numbers of the waiting requests, in their order of arrival
+        uint64_t                next    = 0; // number of the next request to wait
+        double                  average = 1; // seconds taken by a request, moving average
+    };
+
+    Admission() = default;
+
+    bool     enter(Class kind);
+    void     leave(Class kind, std::chrono::steady_clock::duration duration);
+    unsigned retryAfter(Class kind) const;
+    double   expectedWait(const Queue& queue) const;
+
+private:
+    mutable std::mutex                      m_mutex;
+    std::array<Queue, size_t(Class::Count)> m_queues;
+};
+
+} // namespace fty::asset
@@ -0,0 +1,61 @@
+/*  ====================================================================================================================
+    asset-events.cpp - In-process announcement of asset changes
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "asset-events.h"
+#include <mutex>
+#include <vector>
+
+namespace fty::asset::events {
+
+struct Listeners
+{
+    std::mutex            mutex;
+    std::vector<Listener> list;
+};
+
+static Listeners& listeners()
+{
+    static Listeners inst;
+    return inst;
+}
+
+void subscribe(Listener listener)
+{
+    auto&                       inst = listeners();
+    std::lock_guard<std::mutex> lock(inst.mutex);
+    inst.list.push_back(std::move(listener));
+}
+
+void publish(const Event& event)
+{
+    std::vector<Listener> list;
+    {
+        auto&                       inst = listeners();
+        std::lock_guard<std::mutex> lock(inst.mutex);
+        list = inst.list;
+    }
+
+    for (const auto& listener : list) {
+        listener(event);
+    }
+}
+
+} // namespace fty::asset::events
@@ -0,0 +1,56 @@
+/*  ====================================================================================================================
+    asset-events.h - In-process announcement of asset changes
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace fty::asset::events {
+
+enum class Type
+{
+    Created,
+    Updated,
+    Deleted,
+    Reset // unspecified set of assets was changed (import)
+};
+
+struct Event
+{
+    Type        type;
+    uint32_t    id       = 0;
+    std::string name;
+    uint32_t    parentId = 0;     // 0 if not known
+    bool        external = false; // announced on the asset streams, only the name is known
+};
+
+using Listener = std::function<void(const Event&)>;
+
+/// Registers a listener of the changes done by the handlers of this library, and of the changes announced on the asset
+/// streams once watchAssetStreams() was called (changes of other agents, and of this library again).
+/// Listeners are called synchronously in the thread which made the change, so they must be cheap.
+void subscribe(Listener listener);
+
+/// Announces a change to all the listeners
+void publish(const Event& event);
+
+} // namespace fty::asset::events
@@ -0,0 +1,237 @@
+/*  ====================================================================================================================
+    batch-read.cpp - Reads of many assets in a few statements
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "batch-read.h"
+#include "db-pool.h"
+#include "metrics.h"
+#include <fmt/format.h>
+#include <fty_common_db_connection.h>
+
+namespace fty::asset::batch {
+
+// Names of the bound values: :id0, :id1...
+static const std::vector<std::string>& paramNames()
+{
+    static const std::vector<std::string> names = []() {
+        std::vector<std::string> ret;
+        for (size_t i = 0; i < Size; ++i) {
+            ret.push_back(fmt::format("id{}", i));
+        }
+        return ret;
+    }();
+    return names;
+}
+
+// ":id0, :id1..." for an IN clause
+static std::string params()
+{
+    std::string ret;
+    for (const auto& name : paramNames()) {
+        ret += (ret.empty() ? ":" : ", :") + name;
+    }
+    return ret;
+}
+
+// Runs the statement once per Size values, with the values missing in the last batch replaced by padding
+template <typename T, typename Func>
+static void select(fty::db::Connection& conn, const std::string& sql, const std::vector<T>& values, const T& padding, Func&& func)
+{
+    const auto& names = paramNames();
+    for (size_t from = 0; from < values.size(); from += Size) {
+        metrics::DbCall call;
+        auto            st = prepareCached(conn, sql);
+        for (size_t i = 0; i < Size; ++i) {
+            st.bind(names[i], from + i < values.size() ? values[from + i] : padding);
+        }
+        for (const auto& row : st.select()) {
+            call.rows(1);
+            func(row);
+        }
+    }
+}
+
+size_t statements(size_t count, size_t perBatch)
+{
+    return (count + Size - 1) / Size * perBatch;
+}
+
+// =========================================================================================================================================
+
+std::unordered_map<uint32_t, Element> elements(fty::db::Connection& conn, const std::vector<uint32_t>& ids)
+{
+    // clang-format off
+    static const std::string sql = fmt::format(R"(
+        SELECT e.id_asset_element AS id, e.name, COALESCE(n.value, e.name) AS extName, e.id_type AS typeId,
+            e.id_subtype AS subTypeId, e.status, e.priority, COALESCE(e.asset_tag, '') AS assetTag,
+            COALESCE(e.id_parent, 0) AS parentId, COALESCE(p.id_type, 0) AS parentTypeId, COALESCE(p.name, '') AS parentName,
+            COALESCE(pn.value, p.name, '') AS parentExtName
+        FROM t_bios_asset_element e
+        LEFT JOIN t_bios_asset_ext_attributes n ON n.id_asset_element = e.id_asset_element AND n.keytag = 'name'
+        LEFT JOIN t_bios_asset_element p ON p.id_asset_element = e.id_parent
+        LEFT JOIN t_bios_asset_ext_attributes pn ON pn.id_asset_element = p.id_asset_element AND pn.keytag = 'name'
+        WHERE e.id_asset_element IN ({})
+    )", params());
+    // clang-format on
+
+    std::unordered_map<uint32_t, Element> ret;
+    select(conn, sql, ids, uint32_t(0), [&](const fty::db::Row& row) {
+        Element el;
+        el.id            = row.get<uint32_t>("id");
+        el.typeId        = row.get<uint16_t>("typeId");
+        el.subTypeId     = row.get<uint16_t>("subTypeId");
+        el.priority      = row.get<uint16_t>("priority");
+        el.parentId      = row.get<uint32_t>("parentId");
+        el.parentTypeId  = row.get<uint16_t>("parentTypeId");
+        el.name          = row.get("name");
+        el.extName       = row.get("extName");
+        el.status        = row.get("status");
+        el.assetTag      = row.get("assetTag");
+        el.parentName    = row.get("parentName");
+        el.parentExtName = row.get("parentExtName");
+        ret.emplace(el.id, std::move(el));
+    });
+    return ret;
+}
+
+std::unordered_map<uint32_t, Attributes> attributes(fty::db::Connection& conn, const std::vector<uint32_t>& ids)
+{
+    // clang-format off
+    static const std::string sql = fmt::format(R"(
+        SELECT a.id_asset_element AS id, a.keytag, a.value, a.read_only AS readOnly, COALESCE(ln.value, l.name, '') AS extName
+        FROM t_bios_asset_ext_attributes a
+        LEFT JOIN t_bios_asset_element l ON a.keytag = 'logical_asset' AND l.name = a.value
+        LEFT JOIN t_bios_asset_ext_attributes ln ON ln.id_asset_element = l.id_asset_element AND ln.keytag = 'name'
+        WHERE a.id_asset_element IN ({})
+    )", params());
+    // clang-format on
+
+    std::unordered_map<uint32_t, Attributes> ret;
+    select(conn, sql, ids, uint32_t(0), [&](const fty::db::Row& row) {
+        auto& attr    = ret[row.get<uint32_t>("id")][row.get("keytag")];
+        attr.value    = row.get("value");
+        attr.readOnly = row.get<bool>("readOnly");
+        attr.extName  = row.get("extName");
+    });
+    return ret;
+}
+
+std::unordered_map<uint32_t, std::vector<Link>> powerLinks(fty::db::Connection& conn, const std::vector<uint32_t>& ids)
+{
+    // clang-format off
+    static const std::string sql = fmt::format(R"(
+        SELECT l.id_asset_device_dest AS id, s.name AS srcName, COALESCE(n.value, s.name) AS srcExtName,
+            COALESCE(l.src_out, '') AS srcSocket, COALESCE(l.dest_in, '') AS destSocket
+        FROM t_bios_asset_link l
+        INNER JOIN t_bios_asset_link_type t ON t.id_asset_link_type = l.id_asset_link_type
+        INNER JOIN t_bios_asset_element s ON s.id_asset_element = l.id_asset_device_src
+        LEFT JOIN t_bios_asset_ext_attributes n ON n.id_asset_element = s.id_asset_element AND n.keytag = 'name'
+        WHERE t.name = 'power chain' AND l.id_asset_device_dest IN ({})
+        ORDER BY l.id_link
+    )", params());
+    // clang-format on
+
+    std::unordered_map<uint32_t, std::vector<Link>> ret;
+    select(conn, sql, ids, uint32_t(0), [&](const fty::db::Row& row) {
+        auto& link      = ret[row.get<uint32_t>("id")].emplace_back();
+        link.srcName    = row.get("srcName");
+        link.srcExtName = row.get("srcExtName");
+        link.srcSocket  = row.get("srcSocket");
+        link.destSocket = row.get("destSocket");
+    });
+    return ret;
+}
+
+std::map<uint32_t, std::string> extNames(fty::db::Connection& conn, const std::vector<uint32_t>& ids)
+{
+    static const std::string sql = fmt::format(
+        "SELECT id_asset_element AS id, value FROM t_bios_asset_ext_attributes WHERE keytag = 'name' AND id_asset_element IN ({})",
+        params());
+
+    std::map<uint32_t, std::string> ret;
+    select(conn, sql, ids, uint32_t(0), [&](const fty::db::Row& row) {
+        ret.emplace(row.get<uint32_t>("id"), row.get("value"));
+    });
+    return ret;
+}
+
+std::map<uint32_t, std::string> extNamesOfType(fty::db::Connection& conn, uint16_t typeId)
+{
+    // clang-format off
+    static const std::string sql = R"(
+        SELECT e.id_asset_element AS id, COALESCE(n.value, e.name) AS extName
+        FROM t_bios_asset_element e
+        LEFT JOIN t_bios_asset_ext_attributes n ON n.id_asset_element = e.id_asset_element AND n.keytag = 'name'
+        WHERE e.id_type = :typeId
+    )";
+    // clang-format on
+
+    std::map<uint32_t, std::string> ret;
+    metrics::DbCall                 call;
+    for (const auto& row : prepareCached(conn, sql).bind("typeId", typeId).select()) {
+        call.rows(1);
+        ret.emplace(row.get<uint32_t>("id"), row.get("extName"));
+    }
+    return ret;
+}
+
+std::map<std::string, uint32_t> ids(fty::db::Connection& conn, const std::vector<std::string>& names)
+{
+    std::map<std::string, uint32_t> ret;
+    for (const auto& [name, asset] : named(conn, names)) {
+        ret.emplace(name, asset.id);
+    }
+    return ret;
+}
+
+std::map<std::string, Named> named(fty::db::Connection& conn, const std::vector<std::string>& names)
+{
+    static const std::string sql = fmt::format(
+        "SELECT id_asset_element AS id, name, id_type AS typeId FROM t_bios_asset_element WHERE name IN ({})", params());
+
+    // no asset has an empty name
+    std::map<std::string, Named> ret;
+    select(conn, sql, names, std::string(), [&](const fty::db::Row& row) {
+        auto& asset  = ret[row.get("name")];
+        asset.id     = row.get<uint32_t>("id");
+        asset.typeId = row.get<uint16_t>("typeId");
+    });
+    return ret;
+}
+
+std::map<std::string, std::map<std::string, std::string>> endpoints(fty::db::Connection& conn, const std::vector<std::string>& names)
+{
+    // clang-format off
+    static const std::string sql = fmt::format(R"(
+        SELECT e.name AS name, a.keytag AS keytag, a.value AS value
+        FROM t_bios_asset_ext_attributes AS a
+        INNER JOIN t_bios_asset_element AS e ON e.id_asset_element = a.id_asset_element
+        WHERE a.keytag LIKE 'endpoint.%' AND e.name IN ({})
+    )", params());
+    // clang-format on
+
+    std::map<std::string, std::map<std::string, std::string>> ret;
+    select(conn, sql, names, std::string(), [&](const fty::db::Row& row) {
+        ret[row.get("name")].emplace(row.get("keytag"), row.get("value"));
+    });
+    return ret;
+}
+
+} // namespace fty::asset::batch
@@ -0,0 +1,115 @@
+/*  ====================================================================================================================
+    batch-read.h - Reads of many assets in a few statements
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fty::db {
+class Connection;
+}
+
+namespace fty::asset::batch {
+
+/// Reads of many assets at once, for the listings and bulk requests: the number of statements does not grow with the
+/// number of assets (up to Size of them, one more statement per Size assets above).
+/// Statements bind Size values, padded with values matching no asset, so that their text never changes and they are
+/// prepared once per connection (see prepareCached()).
+
+/// Values bound in one statement
+static constexpr size_t Size = 1000;
+
+/// Statements run by a read of `count` assets made of `perBatch` statements
+size_t statements(size_t count, size_t perBatch = 1);
+
+/// Asset element with the names of its parent
+struct Element
+{
+    uint32_t    id           = 0;
+    uint16_t    typeId       = 0;
+    uint16_t    subTypeId    = 0;
+    uint16_t    priority     = 0;
+    uint32_t    parentId     = 0;
+    uint16_t    parentTypeId = 0;
+    std::string name;
+    std::string extName;
+    std::string status;
+    std::string assetTag;
+    std::string parentName;
+    std::string parentExtName;
+};
+
+/// Ext attribute
+struct Attribute
+{
+    std::string value;
+    bool        readOnly = false;
+    std::string extName; // external name of the asset named by the value, for logical_asset only
+};
+
+/// Ext attributes of an asset, sorted by key
+using Attributes = std::map<std::string, Attribute>;
+
+/// Power link to an asset
+struct Link
+{
+    std::string srcName;
+    std::string srcExtName;
+    std::string srcSocket;
+    std::string destSocket;
+};
+
+/// Elements by id, missing assets are left out
+std::unordered_map<uint32_t, Element> elements(fty::db::Connection& conn, const std::vector<uint32_t>& ids);
+
+/// Ext attributes by id of asset, assets without any are left out
+std::unordered_map<uint32_t, Attributes> attributes(fty::db::Connection& conn, const std::vector<uint32_t>& ids);
+
+/// Power links by id of the powered asset
+std::unordered_map<uint32_t, std::vector<Link>> powerLinks(fty::db::Connection& conn, const std::vector<uint32_t>& ids);
+
+/// External names by id, assets without one are left out
+std::map<uint32_t, std::string> extNames(fty::db::Connection& conn, const std::vector<uint32_t>& ids);
+
+/// External names of all the assets of a type, by id, in one statement
+std::map<uint32_t, std::string> extNamesOfType(fty::db::Connection& conn, uint16_t typeId);
+
+/// Asset found by internal name
+struct Named
+{
+    uint32_t id     = 0;
+    uint16_t typeId = 0;
+};
+
+/// Ids by internal name, unknown names are left out
+std::map<std::string, uint32_t> ids(fty::db::Connection& conn, const std::vector<std::string>& names);
+
+/// Ids and types by internal name, unknown names are left out
+std::map<std::string, Named> named(fty::db::Connection& conn, const std::vector<std::string>& names);
+
+/// Endpoint attributes (endpoint.*) by internal name of asset, assets without any are left out
+std::map<std::string, std::map<std::string, std::string>> endpoints(fty::db::Connection& conn, const std::vector<std::string>& names);
+
+} // namespace fty::asset::batch
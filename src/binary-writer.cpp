@@ -0,0 +1,227 @@
+/*  ====================================================================================================================
+    binary-writer.cpp - MessagePack and CBOR encoding of the replies
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "binary-writer.h"
+#include <fty/string-utils.h>
+
+namespace fty::asset {
+
+static constexpr const char* MsgPackType = "application/msgpack";
+static constexpr const char* CborType    = "application/cbor";
+
+std::optional<BinaryWriter::Format> BinaryWriter::negotiate(const std::string& accept)
+{
+    // highest quality wins, the first one listed on a tie
+    std::optional<Format> ret;
+    double                best = 0;
+
+    for (auto item : split(accept, ",")) {
+        auto   params = split(item, ";");
+        auto   type   = trimmed(params.empty() ? item : params[0]);
+        double q      = 1;
+        for (size_t i = 1; i < params.size(); ++i) {
+            auto param = trimmed(params[i]);
+            if (param.substr(0, 2) == "q=") {
+                q = std::atof(param.c_str() + 2);
+            }
+        }
+
+        std::optional<Format> format;
+        if (type == MsgPackType || type == "application/x-msgpack" || type == "application/vnd.msgpack") {
+            format = Format::MsgPack;
+        } else if (type == CborType) {
+            format = Format::Cbor;
+        } else if (type != "application/json" && type != "*/*" && type != "application/*") {
+            continue;
+        }
+
+        if (q > best) {
+            best = q;
+            ret  = format;
+        }
+    }
+    return ret;
+}
+
+BinaryWriter::BinaryWriter(Format format)
+    : m_format(format)
+{
+}
+
+const char* BinaryWriter::contentType() const
+{
+    return m_format == Format::MsgPack ? MsgPackType : CborType;
+}
+
+const std::string& BinaryWriter::data() const
+{
+    return m_data;
+}
+
+// =========================================================================================================================================
+
+void BinaryWriter::bigEndian(uint64_t value, size_t bytes)
+{
+    for (size_t i = bytes; i > 0; --i) {
+        m_data += char((value >> ((i - 1) * 8)) & 0xff);
+    }
+}
+
+// CBOR header of the major type: the value itself when small, else its size followed by the value
+void BinaryWriter::head(uint8_t major, uint64_t value)
+{
+    uint8_t type = uint8_t(major << 5);
+    if (value < 24) {
+        m_data += char(type | value);
+    } else if (value <= 0xff) {
+        m_data += char(type | 24);
+        bigEndian(value, 1);
+    } else if (value <= 0xffff) {
+        m_data += char(type | 25);
+        bigEndian(value, 2);
+    } else if (value <= 0xffffffff) {
+        m_data += char(type | 26);
+        bigEndian(value, 4);
+    } else {
+        m_data += char(type | 27);
+        bigEndian(value, 8);
+    }
+}
+
+void BinaryWriter::null()
+{
+    m_data += char(m_format == Format::MsgPack ? 0xc0 : 0xf6);
+}
+
+void BinaryWriter::boolean(bool value)
+{
+    if (m_format == Format::MsgPack) {
+        m_data += char(value ? 0xc3 : 0xc2);
+    } else {
+        m_data += char(value ? 0xf5 : 0xf4);
+    }
+}
+
+void BinaryWriter::uint(uint64_t value)
+{
+    if (m_format == Format::Cbor) {
+        head(0, value);
+    } else if (value < 0x80) {
+        m_data += char(value);
+    } else if (value <= 0xff) {
+        m_data += char(0xcc);
+        bigEndian(value, 1);
+    } else if (value <= 0xffff) {
+        m_data += char(0xcd);
+        bigEndian(value, 2);
+    } else if (value <= 0xffffffff) {
+        m_data += char(0xce);
+        bigEndian(value, 4);
+    } else {
+        m_data += char(0xcf);
+        bigEndian(value, 8);
+    }
+}
+
+void BinaryWriter::string(std::string_view value)
+{
+    if (m_format == Format::Cbor) {
+        head(3, value.size());
+    } else if (value.size() < 32) {
+        m_data += char(0xa0 | value.size());
+    } else if (value.size() <= 0xff) {
+        m_data += char(0xd9);
+        bigEndian(value.size(), 1);
+    } else if (value.size() <= 0xffff) {
+        m_data += char(0xda);
+        bigEndian(value.size(), 2);
+    } else {
+        m_data += char(0xdb);
+        bigEndian(value.size(), 4);
+    }
+    m_data.append(value.data(), value.size());
+}
+
+void BinaryWriter::array(size_t size)
+{
+    if (m_format == Format::Cbor) {
+        head(4, size);
+    } else if (size < 16) {
+        m_data += char(0x90 | size);
+    } else if (size <= 0xffff) {
+        m_data += char(0xdc);
+        bigEndian(size, 2);
+    } else {
+        m_data += char(0xdd);
+        bigEndian(size, 4);
+    }
+}
+
+void BinaryWriter::map(size_t size)
+{
+    if (m_format == Format::Cbor) {
+        head(5, size);
+    } else if (size < 16) {
+        m_data += char(0x80 | size);
+    } else if (size <= 0xffff) {
+        m_data += char(0xde);
+        bigEndian(size, 2);
+    } else {
+        m_data += char(0xdf);
+        bigEndian(size, 4);
+    }
+}
+
+// =========================================================================================================================================
+
+void write(BinaryWriter& out, const pack::String& value, bool)
+{
+    out.string(value.value());
+}
+
+void write(BinaryWriter& out, const pack::UInt32& value, bool)
+{
+    out.uint(value.value());
+}
+
+void write(BinaryWriter& out, const pack::Bool& value, bool)
+{
+    out.boolean(value.value());
+}
+
+void write(BinaryWriter& out, const pack::StringList& list, bool)
+{
+    out.array(size_t(list.size()));
+    for (const auto& item : list) {
+        out.string(item);
+    }
+}
+
+void write(BinaryWriter& out, const pack::StringMap& map, bool)
+{
+    out.map(size_t(map.size()));
+    for (const auto& [key, value] : map) {
+        out.string(key);
+        out.string(value);
+    }
+}
+
+} // namespace fty::asset
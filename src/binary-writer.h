@@ -0,0 +1,117 @@
+/*  ====================================================================================================================
+    binary-writer.h - MessagePack and CBOR encoding of the replies
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <pack/pack.h>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace fty::asset {
+
+/// Compact binary encoding of the replies, for clients asking for it in the Accept header.
+/// DTOs are written with `write(BinaryWriter&, const Dto&, bool defaults)` overloads next to their definition, see `object()`.
+class BinaryWriter
+{
+public:
+    enum class Format
+    {
+        MsgPack,
+        Cbor
+    };
+
+    /// Binary format preferred by the client, none if it prefers JSON (or does not tell)
+    static std::optional<Format> negotiate(const std::string& accept);
+
+    explicit BinaryWriter(Format format);
+
+    const char* contentType() const;
+
+    void null();
+    void boolean(bool value);
+    void uint(uint64_t value);
+    void string(std::string_view value);
+    void array(size_t size);
+    void map(size_t size);
+
+    const std::string& data() const;
+
+    /// Writes the fields as a map. Without defaults, fields without value are left out (as in JSON).
+    template <typename... Fields>
+    void object(bool defaults, const Fields&... fields)
+    {
+        map((size_t(defaults || fields.second.hasValue()) + ... + 0));
+        (writeField(defaults, fields.first, fields.second), ...);
+    }
+
+private:
+    void head(uint8_t major, uint64_t value);
+    void bigEndian(uint64_t value, size_t bytes);
+
+    template <typename T>
+    void writeField(bool defaults, const char* key, const T& value)
+    {
+        if (defaults || value.hasValue()) {
+            string(key);
+            write(*this, value, defaults);
+        }
+    }
+
+private:
+    Format      m_format;
+    std::string m_data;
+};
+
+/// Field of a DTO for BinaryWriter::object()
+template <typename T>
+std::pair<const char*, const T&> binaryField(const char* key, const T& value)
+{
+    return {key, value};
+}
+
+void write(BinaryWriter& out, const pack::String& value, bool defaults);
+void write(BinaryWriter& out, const pack::UInt32& value, bool defaults);
+void write(BinaryWriter& out, const pack::Bool& value, bool defaults);
+void write(BinaryWriter& out, const pack::StringList& list, bool defaults);
+void write(BinaryWriter& out, const pack::StringMap& map, bool defaults);
+
+template <typename T>
+void write(BinaryWriter& out, const pack::ObjectList<T>& list, bool defaults)
+{
+    out.array(size_t(list.size()));
+    for (const auto& item : list) {
+        write(out, item, defaults);
+    }
+}
+
+template <typename T>
+void write(BinaryWriter& out, const pack::Map<T>& map, bool defaults)
+{
+    out.map(size_t(map.size()));
+    for (const auto& [key, value] : map) {
+        out.string(key);
+        write(out, value, defaults);
+    }
+}
+
+} // namespace fty::asset
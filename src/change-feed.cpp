@@ -0,0 +1,142 @@
+/*  ====================================================================================================================
+    change-feed.cpp - Recent changes of assets for the clients
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "change-feed.h"
+#include <fmt/format.h>
+#include <random>
+
+namespace fty::asset {
+
+ChangeFeed& ChangeFeed::instance()
+{
+    static ChangeFeed feed;
+    return feed;
+}
+
+ChangeFeed::ChangeFeed()
+{
+    // tokens of another run of the server are recognized and answered with a reset
+    m_epoch = fmt::format("{:x}", std::random_device{}());
+
+    events::subscribe([this](const events::Event& event) {
+        onEvent(event);
+    });
+}
+
+void ChangeFeed::onEvent(const events::Event& event)
+{
+    // the feed lists the changes made through this library, stream notifications repeat them without ids
+    if (event.external) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_changes.push_back({++m_last, event.type, event.id, event.name});
+        if (m_changes.size() > Capacity) {
+            m_changes.pop_front();
+        }
+    }
+    m_changed.notify_all();
+}
+
+std::string ChangeFeed::tokenOf(uint64_t seq) const
+{
+    return fmt::format("{}-{}", m_epoch, seq);
+}
+
+std::string ChangeFeed::token() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return tokenOf(m_last);
+}
+
+ChangeFeed::Batch ChangeFeed::wait(const std::string& token, size_t limit, std::chrono::milliseconds timeout)
+{
+    Batch ret;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    uint64_t since = m_last;
+    auto     dash  = token.rfind('-');
+    if (dash != std::string::npos && token.compare(0, dash, m_epoch) == 0) {
+        try {
+            since = std::stoull(token.substr(dash + 1));
+        } catch (const std::exception&) {
+            ret.reset = true;
+        }
+    } else {
+        ret.reset = true;
+    }
+
+    // changes after since are not all kept anymore, or token from the future
+    uint64_t oldest = m_changes.empty() ? m_last + 1 : m_changes.front().seq;
+    if (ret.reset || since + 1 < oldest || since > m_last) {
+        ret.reset = true;
+        ret.token = tokenOf(m_last);
+        return ret;
+    }
+
+    if (since == m_last && timeout.count() > 0) {
+        if (m_waiters >= MaxWaiters) {
+            ret.busy  = true;
+            ret.token = token;
+            return ret;
+        }
+
+        ++m_waiters;
+        m_changed.wait_for(lock, timeout, [&]() {
+            return m_last != since;
+        });
+        --m_waiters;
+
+        // the client was so slow the waited changes are already gone
+        if (!m_changes.empty() && since + 1 < m_changes.front().seq) {
+            ret.reset = true;
+            ret.token = tokenOf(m_last);
+            return ret;
+        }
+    }
+
+    uint64_t next = since;
+    if (!m_changes.empty()) {
+        // sequence numbers are contiguous, the first change after since is found directly
+        size_t first = size_t(since + 1 - m_changes.front().seq);
+
+        // unknown changes (import), the client reloads everything including the changes after it
+        for (size_t i = first; i < m_changes.size(); ++i) {
+            if (m_changes[i].type == events::Type::Reset) {
+                ret.reset = true;
+                ret.token = tokenOf(m_last);
+                return ret;
+            }
+        }
+
+        for (size_t i = first; i < m_changes.size() && ret.changes.size() < limit; ++i) {
+            ret.changes.push_back(m_changes[i]);
+            next = m_changes[i].seq;
+        }
+    }
+    ret.token = tokenOf(next);
+    return ret;
+}
+
+} // namespace fty::asset
@@ -0,0 +1,83 @@
+/*  ====================================================================================================================
+    change-feed.h - Recent changes of assets for the clients
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include "asset-events.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace fty::asset {
+
+/// Last changes done through this library, numbered, for clients following them instead of polling the assets.
+/// Only the last Capacity changes are kept: a client which is further behind is told to reload everything.
+class ChangeFeed
+{
+public:
+    static constexpr size_t Capacity = 4096;
+
+    /// Clients waiting at the same time, the others are told the feed is busy
+    static constexpr size_t MaxWaiters = 32;
+
+    struct Change
+    {
+        uint64_t     seq = 0;
+        events::Type type;
+        uint32_t     id = 0;
+        std::string  name;
+    };
+
+    struct Batch
+    {
+        std::vector<Change> changes;
+        std::string         token;         // resume token after this batch
+        bool                reset = false; // changes were lost (client too far behind, restart, import), reload everything
+        bool                busy  = false; // too many clients waiting, the client did not wait and should come back later
+    };
+
+    static ChangeFeed& instance();
+
+    /// Token of the current position, for clients starting to follow
+    std::string token() const;
+
+    /// Changes after the token, waits up to timeout for at least one.
+    /// A Reset event is not a change of the batch: the batch is a reset, positioned after the last change.
+    Batch wait(const std::string& token, size_t limit, std::chrono::milliseconds timeout);
+
+private:
+    ChangeFeed();
+    void onEvent(const events::Event& event);
+
+    std::string tokenOf(uint64_t seq) const;
+
+private:
+    mutable std::mutex      m_mutex;
+    std::condition_variable m_changed;
+    std::deque<Change>      m_changes;
+    uint64_t                m_last    = 0;
+    size_t                  m_waiters = 0;
+    std::string             m_epoch;
+};
+
+} // namespace fty::asset
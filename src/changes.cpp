@@ -0,0 +1,163 @@
+#include "changes.h"
+#include "change-feed.h"
+#include "metrics.h"
+#include <fty/rest/component.h>
+#include <pack/node.h>
+#include <algorithm>
+
+namespace fty::asset {
+
+struct ChangeItem : public pack::Node
+{
+    pack::UInt64 seq       = FIELD("seq");
+    pack::String operation = FIELD("operation");
+    pack::String id        = FIELD("id");
+
+    using pack::Node::Node;
+    META(ChangeItem, seq, operation, id);
+};
+
+struct ChangeList : public pack::Node
+{
+    pack::String                 token   = FIELD("token");
+    pack::Bool                   reset   = FIELD("reset");
+    pack::ObjectList<ChangeItem> changes = FIELD("changes");
+
+    using pack::Node::Node;
+    META(ChangeList, token, reset, changes);
+};
+
+// =========================================================================================================================================
+
+static constexpr size_t               DefaultLimit   = 500;
+static constexpr std::chrono::seconds DefaultTimeout = std::chrono::seconds(25);
+static constexpr std::chrono::seconds MaxTimeout     = std::chrono::seconds(60);
+static constexpr std::chrono::seconds BusyRetry      = std::chrono::seconds(30);
+
+static const char* operation(events::Type type)
+{
+    switch (type) {
+        case events::Type::Created:
+            return "create";
+        case events::Type::Updated:
+            return "update";
+        case events::Type::Deleted:
+            return "delete";
+        case events::Type::Reset:
+            return "reset";
+    }
+    return "unknown";
+}
+
+static size_t number(const std::string& name, const std::string& value, size_t max)
+{
+    // digits only: stoul() would accept a sign, spaces and trailing garbage
+    if (!value.empty() && value.size() <= 6 && std::all_of(value.begin(), value.end(), ::isdigit)) {
+        if (size_t ret = std::stoul(value); ret <= max) {
+            return ret;
+        }
+    }
+    throw rest::errors::RequestParamBad(name, value, "number from 0 to {}"_tr.format(max));
+}
+
+unsigned Changes::run()
+{
+    static auto&     stats = metrics::endpoint("asset/changes");
+    metrics::Request measure(stats, m_reply);
+    measure.budget(0);
+
+    metrics::Scope permissions(metrics::Phase::Permissions);
+    rest::User     user(m_request);
+    if (auto ret = checkPermissions(user.profile(), m_permissions); !ret) {
+        throw rest::Error(ret.error());
+    }
+    permissions.stop();
+
+    if (m_request.type() != rest::Request::Type::Get) {
+        throw rest::errors::MethodNotAllowed(m_request.typeStr());
+    }
+
+    auto& feed = ChangeFeed::instance();
+
+    // EventSource clients resume with the id of the last event they got, which is newer than the token of the URL
+    // they were opened with
+    std::string token = m_request.header("Last-Event-ID");
+    if (auto arg = m_request.queryArg<std::string>("token"); arg && token.empty()) {
+        token = *arg;
+    }
+
+    size_t limit = DefaultLimit;
+    if (auto arg = m_request.queryArg<std::string>("limit")) {
+        limit = std::max<size_t>(1, number("limit", *arg, ChangeFeed::Capacity));
+    }
+
+    std::chrono::milliseconds timeout = DefaultTimeout;
+    if (auto arg = m_request.queryArg<std::string>("timeout")) {
+        timeout = std::chrono::seconds(number("timeout", *arg, size_t(MaxTimeout.count())));
+    }
+
+    // without token the client starts to follow from now on
+    ChangeFeed::Batch batch;
+    if (token.empty()) {
+        batch.token = feed.token();
+    } else {
+        batch = feed.wait(token, limit, timeout);
+    }
+
+    metrics::Scope serialization(metrics::Phase::Serialization);
+
+    bool sse = m_request.header("Accept").find("text/event-stream") != std::string::npos;
+    m_reply.setHeader("Vary:", "Accept");
+    if (batch.busy) {
+        metrics::rejected();
+        m_reply.setHeader("Retry-After:", std::to_string(BusyRetry.count()));
+        if (sse) {
+            m_reply.setContentType("text/event-stream");
+            m_reply << "retry: " << std::chrono::milliseconds(BusyRetry).count() << "\n\n";
+        }
+        return HTTP_SERVICE_UNAVAILABLE;
+    }
+
+    if (sse) {
+        // one batch per response, EventSource reconnects right away with the Last-Event-ID it got
+        m_reply.setContentType("text/event-stream");
+        m_reply.setHeader("Cache-Control:", "no-cache");
+        m_reply << "retry: 100\n\n";
+        if (batch.reset) {
+            m_reply << "id: " << batch.token << "\nevent: reset\ndata: {}\n\n";
+            return HTTP_OK;
+        }
+        // nothing happened: the id alone moves the client forward without an event
+        if (batch.changes.empty()) {
+            m_reply << "id: " << batch.token << "\n\n";
+            return HTTP_OK;
+        }
+        for (size_t i = 0; i < batch.changes.size(); ++i) {
+            const auto& change = batch.changes[i];
+            // only the last event carries the resume token, the ones before can not be resumed from on their own
+            if (i + 1 == batch.changes.size()) {
+                m_reply << "id: " << batch.token << "\n";
+            }
+            m_reply << "event: " << operation(change.type) << "\n";
+            m_reply << "data: {\"seq\": " << change.seq << ", \"id\": \"" << change.name << "\"}\n\n";
+        }
+        return HTTP_OK;
+    }
+
+    ChangeList list;
+    list.token = batch.token;
+    list.reset = batch.reset;
+    for (const auto& change : batch.changes) {
+        auto& item     = list.changes.append();
+        item.seq       = change.seq;
+        item.operation = operation(change.type);
+        item.id        = change.name;
+    }
+    m_reply << *pack::json::serialize(list, pack::Option::WithDefaults);
+
+    return HTTP_OK;
+}
+
+} // namespace fty::asset
+
+registerHandler(fty::asset::Changes)
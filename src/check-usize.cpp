@@ -1,6 +1,10 @@
 #include "check-usize.h"
+#include "batch-read.h"
+#include "db-pool.h"
+#include "metrics.h"
+#include "rack-index.h"
 #include <asset/asset-helpers.h>
-#include <asset/asset-db.h>
+#include <fty_common_db_connection.h>
 #include <fty/rest/audit-log.h>
 #include <fty/rest/component.h>
 
@@ -19,10 +23,17 @@ struct Request : public pack::Node
 
 unsigned CheckUSize::run()
 {
-    rest::User user(m_request);
+    static auto&     stats = metrics::endpoint("asset/fit_in_rack");
+    metrics::Request measure(stats, m_reply);
+    // asset and rack lookup, rack occupancy if not in the index
+    measure.budget(2);
+
+    metrics::Scope permissions(metrics::Phase::Permissions);
+    rest::User     user(m_request);
     if (auto ret = checkPermissions(user.profile(), m_permissions); !ret) {
         throw rest::Error(ret.error());
     }
+    permissions.stop();
 
     if (m_request.type() != rest::Request::Type::Post) {
         throw rest::errors::MethodNotAllowed(m_request.typeStr());
@@ -33,10 +44,12 @@ unsigned CheckUSize::run()
         throw rest::errors::BadInput("Payload is empty"_tr);
     }
 
-    Request input;
+    metrics::Scope parsing(metrics::Phase::Serialization);
+    Request        input;
     if (auto ret = pack::json::deserialize(json, input); !ret) {
         throw rest::errors::BadInput(ret.error());
     }
+    parsing.stop();
 
     if (input.parentId.empty()) {
         throw rest::errors::BadInput("Rack id couldn't be empty");
@@ -50,27 +63,52 @@ unsigned CheckUSize::run()
         throw rest::errors::BadInput("Asset position is not set");
     }
 
+    metrics::Scope       dbScope(metrics::Phase::Db);
+    DbPool::Lease        lease;
+    fty::db::Connection& conn = lease.connection();
+
+    measure.param("rack_id", input.parentId.value());
+
+    // asset and rack in one read
+    std::vector<std::string> names = {input.parentId.value()};
+    if (input.id.hasValue() && !input.id.empty()) {
+        names.push_back(input.id.value());
+    }
+    auto found = batch::named(conn, names);
+
     uint32_t id = 0;
     if (input.id.hasValue() && !input.id.empty()) {
-        if (auto tmp = db::nameToAssetId(input.id)) {
-            id = convert<uint32_t>(*tmp);
+        if (auto asset = found.find(input.id.value()); asset != found.end()) {
+            id = asset->second.id;
         } else {
-            auditError("Wrong asset id {}, Error: {}"_tr, input.id.value(), tmp.error());
+            auditError("Wrong asset id {}"_tr, input.id.value());
             throw rest::errors::RequestParamBad("asset_id", input.id.value(), "asset name");
         }
     }
 
     uint32_t parentId = 0;
-    if (auto tmp = db::nameToAssetId(input.parentId)) {
-        parentId = convert<uint32_t>(*tmp);
+    if (auto parent = found.find(input.parentId.value()); parent != found.end()) {
+        parentId = parent->second.id;
     } else {
-        auditError("Wrong asset id {}, Error: {}"_tr, input.id.value(), tmp.error());
-        throw rest::errors::RequestParamBad("rack_id", input.id.value(), "asset name");
+        auditError("Wrong rack id {}"_tr, input.parentId.value());
+        throw rest::errors::RequestParamBad("rack_id", input.parentId.value(), "asset name");
+    }
+
+    // the index follows the changes done through this library and expires the others, the database is only read for a
+    // rack it does not hold
+    RackIndex::RackPtr rack;
+    try {
+        rack = RackIndex::instance().rack(parentId);
+    } catch (const std::exception& e) {
+        throw rest::errors::Internal(e.what());
+    }
+
+    if (!rack || !rack->size()) {
+        throw rest::errors::Internal("Rack {} has no size"_tr.format(input.parentId.value()));
     }
 
-    auto ret = tryToPlaceAsset(id, parentId, input.usize, input.location);
-    if (!ret) {
-        throw rest::errors::Internal(ret.error());
+    if (!rack->fits(input.location.value(), input.usize.value(), id)) {
+        throw rest::errors::Internal("Asset does not fit in the rack at position {}"_tr.format(input.location.value()));
     }
 
     return HTTP_OK;
@@ -0,0 +1,146 @@
+/*  ====================================================================================================================
+    config.cpp - Runtime settings of the library
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "config.h"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+namespace fty::asset::config {
+
+static bool flag(const char* name)
+{
+    const char* value = std::getenv(name);
+    if (!value) {
+        return false;
+    }
+    std::string str(value);
+    return str == "1" || str == "true" || str == "yes";
+}
+
+static long number(const char* name, long def)
+{
+    const char* value = std::getenv(name);
+    if (!value) {
+        return def;
+    }
+    char* end = nullptr;
+    long  ret = std::strtol(value, &end, 10);
+    return end != value && ret >= 0 ? ret : def;
+}
+
+bool debugHeaders()
+{
+    static const bool value = flag("FTY_ASSET_REST_DEBUG_HEADERS");
+    return value;
+}
+
+std::chrono::milliseconds slowRequest()
+{
+    static const std::chrono::milliseconds value{number("FTY_ASSET_REST_SLOW_REQUEST_MS", 0)};
+    return value;
+}
+
+bool localBus()
+{
+    static const bool value = flag("FTY_ASSET_REST_LOCAL_BUS");
+    return value;
+}
+
+std::chrono::milliseconds localBusLatency()
+{
+    static const std::chrono::milliseconds value{number("FTY_ASSET_REST_LOCAL_BUS_LATENCY_MS", 0)};
+    return value;
+}
+
+std::chrono::milliseconds localBusJitter()
+{
+    static const std::chrono::milliseconds value{number("FTY_ASSET_REST_LOCAL_BUS_JITTER_MS", 0)};
+    return value;
+}
+
+size_t dbPoolSize()
+{
+    static const size_t value = size_t(std::max(number("FTY_ASSET_REST_DB_POOL_SIZE", 8), 1L));
+    return value;
+}
+
+std::chrono::milliseconds dbPoolWait()
+{
+    static const std::chrono::milliseconds value{number("FTY_ASSET_REST_DB_POOL_WAIT_MS", 5000)};
+    return value;
+}
+
+const std::string& dbReplicaUrl()
+{
+    static const std::string value = std::getenv("FTY_ASSET_REST_DB_REPLICA_URL") ? std::getenv("FTY_ASSET_REST_DB_REPLICA_URL") : "";
+    return value;
+}
+
+std::chrono::milliseconds readAfterWrite()
+{
+    static const std::chrono::milliseconds value{number("FTY_ASSET_REST_READ_AFTER_WRITE_MS", 5000)};
+    return value;
+}
+
+size_t heavyLimit()
+{
+    static const size_t value = size_t(std::max(number("FTY_ASSET_REST_HEAVY_LIMIT", 2), 1L));
+    return value;
+}
+
+size_t heavyQueue()
+{
+    static const size_t value = size_t(number("FTY_ASSET_REST_HEAVY_QUEUE", 4));
+    return value;
+}
+
+std::chrono::milliseconds heavyWait()
+{
+    static const std::chrono::milliseconds value{number("FTY_ASSET_REST_HEAVY_WAIT_MS", 2000)};
+    return value;
+}
+
+size_t cacheSize()
+{
+    static const size_t value = size_t(number("FTY_ASSET_REST_CACHE_MB", 32)) * 1024 * 1024;
+    return value;
+}
+
+std::chrono::milliseconds cacheTtl()
+{
+    static const std::chrono::milliseconds value{number("FTY_ASSET_REST_CACHE_TTL_MS", 10000)};
+    return value;
+}
+
+size_t exportWorkers()
+{
+    static const size_t value = size_t(std::max(number("FTY_ASSET_REST_EXPORT_WORKERS", 4), 1L));
+    return value;
+}
+
+size_t activationWorkers()
+{
+    static const size_t value = size_t(std::max(number("FTY_ASSET_REST_ACTIVATION_WORKERS", 4), 1L));
+    return value;
+}
+
+} // namespace fty::asset::config
@@ -0,0 +1,82 @@
+/*  ====================================================================================================================
+    config.h - Runtime settings of the library
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace fty::asset::config {
+
+/// Settings are read once from the environment of the web server.
+
+/// FTY_ASSET_REST_DEBUG_HEADERS=1: adds database statistics of the request to the response headers
+bool debugHeaders();
+
+/// FTY_ASSET_REST_SLOW_REQUEST_MS=<ms>: requests taking longer are logged, 0 (default) disables the log
+std::chrono::milliseconds slowRequest();
+
+/// FTY_ASSET_REST_LOCAL_BUS=1: message bus requests are answered in process instead of going to malamute, for load tests
+bool localBus();
+
+/// FTY_ASSET_REST_LOCAL_BUS_LATENCY_MS=<ms>: time the local bus takes to answer a request
+std::chrono::milliseconds localBusLatency();
+
+/// FTY_ASSET_REST_LOCAL_BUS_JITTER_MS=<ms>: random time added to the latency of the local bus, up to the value
+std::chrono::milliseconds localBusJitter();
+
+/// FTY_ASSET_REST_DB_POOL_SIZE=<n>: database connections shared by the handlers, 8 by default
+size_t dbPoolSize();
+
+/// FTY_ASSET_REST_DB_POOL_WAIT_MS=<ms>: time a request waits for a free connection before failing, 5000 by default
+std::chrono::milliseconds dbPoolWait();
+
+/// FTY_ASSET_REST_DB_REPLICA_URL=<url>: read-only replica of the database used by the listings, none by default
+const std::string& dbReplicaUrl();
+
+/// FTY_ASSET_REST_READ_AFTER_WRITE_MS=<ms>: time the reads of a client go to the primary database after it changed
+/// assets, while the replica catches up, 5000 by default
+std::chrono::milliseconds readAfterWrite();
+
+/// FTY_ASSET_REST_HEAVY_LIMIT=<n>: heavy requests of a kind (export, import, detailed listings, bulk delete) running at
+/// once, 2 by default
+size_t heavyLimit();
+
+/// FTY_ASSET_REST_HEAVY_QUEUE=<n>: heavy requests of a kind waiting for their turn, more are answered 503, 4 by default
+size_t heavyQueue();
+
+/// FTY_ASSET_REST_HEAVY_WAIT_MS=<ms>: time a heavy request waits for its turn before being answered 503, 2000 by default
+std::chrono::milliseconds heavyWait();
+
+/// FTY_ASSET_REST_CACHE_MB=<mb>: memory kept for the replies of the listings, 32 by default, 0 disables the cache
+size_t cacheSize();
+
+/// FTY_ASSET_REST_CACHE_TTL_MS=<ms>: time a cached listing is served, for changes made outside of the handlers, 10000 by
+/// default
+std::chrono::milliseconds cacheTtl();
+
+/// FTY_ASSET_REST_EXPORT_WORKERS=<n>: datacenters exported at once by an export of several of them, 4 by default
+size_t exportWorkers();
+
+/// FTY_ASSET_REST_ACTIVATION_WORKERS=<n>: devices sent to licensing at once by the activation queue, 4 by default
+size_t activationWorkers();
+
+} // namespace fty::asset::config
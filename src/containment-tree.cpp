@@ -0,0 +1,310 @@
+/*  ====================================================================================================================
+    containment-tree.cpp - In-memory tree of asset locations
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "containment-tree.h"
+#include "batch-read.h"
+#include "db-pool.h"
+#include "message-bus.h"
+#include "metrics.h"
+#include <algorithm>
+#include <fty_common_db_connection.h>
+
+namespace fty::asset {
+
+// Above this number of changed assets the whole tree is reloaded
+static constexpr size_t MaxPartialLoad = 1000;
+
+ContainmentTree& ContainmentTree::instance()
+{
+    static ContainmentTree tree;
+    return tree;
+}
+
+ContainmentTree::ContainmentTree()
+{
+    events::subscribe([this](const events::Event& event) {
+        onEvent(event);
+    });
+    watchAssetStreams();
+}
+
+void ContainmentTree::onEvent(const events::Event& event)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (event.external) {
+        m_dirtyNames.insert(event.name);
+    } else if (event.type == events::Type::Reset || !event.id) {
+        m_reset = true;
+    } else {
+        m_dirty.insert(event.id);
+    }
+}
+
+// =========================================================================================================================================
+
+std::vector<ContainmentTree::Node> ContainmentTree::load(fty::db::Connection& conn, const std::vector<uint32_t>& ids)
+{
+    std::vector<Node> ret;
+
+    if (!ids.empty()) {
+        // changed assets, with the statements of the batch reads
+        for (auto& [id, element] : batch::elements(conn, ids)) {
+            Node node;
+            node.id        = id;
+            node.parentId  = element.parentId;
+            node.typeId    = element.typeId;
+            node.subTypeId = element.subTypeId;
+            node.status    = std::move(element.status);
+            node.name      = std::move(element.name);
+            ret.push_back(std::move(node));
+        }
+        return ret;
+    }
+
+    // clang-format off
+    static const std::string sql = R"(
+        SELECT id_asset_element AS id, COALESCE(id_parent, 0) AS parentId, id_type AS typeId, id_subtype AS subTypeId,
+            status, name
+        FROM t_bios_asset_element
+    )";
+    // clang-format on
+
+    metrics::DbCall call;
+    for (const auto& row : prepareCached(conn, sql).select()) {
+        Node node;
+        node.id        = row.get<uint32_t>("id");
+        node.parentId  = row.get<uint32_t>("parentId");
+        node.typeId    = row.get<uint16_t>("typeId");
+        node.subTypeId = row.get<uint16_t>("subTypeId");
+        node.status    = row.get("status");
+        node.name      = row.get("name");
+        ret.push_back(std::move(node));
+    }
+    call.rows(ret.size());
+    return ret;
+}
+
+// =========================================================================================================================================
+
+void ContainmentTree::refresh()
+{
+    std::vector<uint32_t>    dirty;
+    std::vector<std::string> unknown;
+    bool                     full = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        unknown = resolveNames();
+
+        auto now = std::chrono::steady_clock::now();
+        full     = m_reset || now - m_loaded > MaxAge || m_dirty.size() + unknown.size() > MaxPartialLoad;
+        if (full) {
+            m_reset  = false;
+            m_loaded = now;
+        } else {
+            dirty.assign(m_dirty.begin(), m_dirty.end());
+        }
+        m_dirty.clear();
+    }
+
+    if (!full && dirty.empty() && unknown.empty()) {
+        return;
+    }
+
+    // changes announced while loading stay dirty for the next use
+    std::vector<Node> nodes;
+    try {
+        // from the primary database: the tree answers right after the changes made through this library. A request of
+        // this thread holding a connection shares it.
+        DbPool::Lease        lease(DbPool::Target::Primary);
+        fty::db::Connection& conn = lease.connection();
+        if (!full) {
+            // names announced on the streams and not in the tree yet: new assets, or the echo of one created here
+            for (const auto& [name, id] : batch::ids(conn, unknown)) {
+                if (std::find(dirty.begin(), dirty.end(), id) == dirty.end()) {
+                    dirty.push_back(id);
+                }
+            }
+        }
+        nodes = full ? load(conn, {}) : load(conn, dirty);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (full) {
+            m_reset = true;
+        } else {
+            m_dirty.insert(dirty.begin(), dirty.end());
+            m_dirtyNames.insert(unknown.begin(), unknown.end());
+        }
+        throw;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (full) {
+        m_nodes.clear();
+        m_pos.clear();
+    } else {
+        // deleted assets are not loaded anymore
+        for (const auto& id : dirty) {
+            if (auto it = m_pos.find(id); it != m_pos.end()) {
+                m_nodes[it->second].id = 0;
+                m_pos.erase(it);
+            }
+        }
+    }
+    for (auto& node : nodes) {
+        set(std::move(node));
+    }
+    link();
+}
+
+std::vector<std::string> ContainmentTree::resolveNames()
+{
+    std::vector<std::string> unknown;
+    if (m_dirtyNames.empty()) {
+        return unknown;
+    }
+
+    std::set<std::string> found;
+    for (const auto& node : m_nodes) {
+        if (node.id && m_dirtyNames.count(node.name)) {
+            m_dirty.insert(node.id);
+            found.insert(node.name);
+        }
+    }
+    // the others are looked up by name with the changed assets
+    for (const auto& name : m_dirtyNames) {
+        if (!found.count(name)) {
+            unknown.push_back(name);
+        }
+    }
+    m_dirtyNames.clear();
+    return unknown;
+}
+
+void ContainmentTree::set(Node&& node)
+{
+    if (auto it = m_pos.find(node.id); it != m_pos.end()) {
+        m_nodes[it->second] = std::move(node);
+    } else {
+        m_pos.emplace(node.id, uint32_t(m_nodes.size()));
+        m_nodes.push_back(std::move(node));
+    }
+}
+
+void ContainmentTree::link()
+{
+    std::vector<uint32_t> parents(m_nodes.size(), UINT32_MAX);
+    m_first.assign(m_nodes.size() + 1, 0);
+
+    for (uint32_t pos = 0; pos < m_nodes.size(); ++pos) {
+        const auto& node = m_nodes[pos];
+        if (!node.id || !node.parentId) {
+            continue;
+        }
+        if (auto it = m_pos.find(node.parentId); it != m_pos.end()) {
+            parents[pos] = it->second;
+            ++m_first[it->second + 1];
+        }
+    }
+
+    for (size_t pos = 1; pos < m_first.size(); ++pos) {
+        m_first[pos] += m_first[pos - 1];
+    }
+
+    std::vector<uint32_t> fill(m_first.begin(), m_first.end() - 1);
+    m_children.assign(m_first.back(), 0);
+    for (uint32_t pos = 0; pos < m_nodes.size(); ++pos) {
+        if (parents[pos] != UINT32_MAX) {
+            m_children[fill[parents[pos]]++] = pos;
+        }
+    }
+}
+
+// =========================================================================================================================================
+
+// Internal names are generated (<type>-<id>), the database orders them with a case insensitive collation
+static bool byName(const ContainmentTree::Node& l, const ContainmentTree::Node& r)
+{
+    auto lower = [](char ch) {
+        return ch >= 'A' && ch <= 'Z' ? char(ch - 'A' + 'a') : ch;
+    };
+    return std::lexicographical_compare(l.name.begin(), l.name.end(), r.name.begin(), r.name.end(), [&](char a, char b) {
+        return static_cast<unsigned char>(lower(a)) < static_cast<unsigned char>(lower(b));
+    });
+}
+
+std::optional<std::vector<ContainmentTree::Node>> ContainmentTree::descendants(uint32_t container, const Filter& filter)
+{
+    {
+        // one load at a time, other requests wait for it instead of using an outdated tree
+        std::lock_guard<std::mutex> load(m_loadMutex);
+        refresh();
+    }
+
+    auto matches = [&](const Node& node) {
+        if (!filter.types.empty() && std::find(filter.types.begin(), filter.types.end(), node.typeId) == filter.types.end()) {
+            return false;
+        }
+        if (!filter.subTypes.empty() &&
+            std::find(filter.subTypes.begin(), filter.subTypes.end(), node.subTypeId) == filter.subTypes.end()) {
+            return false;
+        }
+        return filter.status.empty() || node.status == filter.status;
+    };
+
+    std::vector<Node> ret;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto root = m_pos.find(container);
+    if (root == m_pos.end()) {
+        return std::nullopt;
+    }
+
+    // breadth first, level by level for the depth limit. Each node once: a partial reload may link a loop until the
+    // rest of the change is loaded.
+    std::vector<bool> visited(m_nodes.size(), false);
+    visited[root->second] = true;
+
+    std::vector<uint32_t> level = {root->second};
+    for (uint32_t depth = 1; !level.empty() && (!filter.depth || depth <= filter.depth); ++depth) {
+        std::vector<uint32_t> next;
+        for (auto pos : level) {
+            for (uint32_t i = m_first[pos]; i < m_first[pos + 1]; ++i) {
+                auto child = m_children[i];
+                if (visited[child]) {
+                    continue;
+                }
+                visited[child]   = true;
+                const auto& node = m_nodes[child];
+                if (matches(node)) {
+                    ret.push_back(node);
+                }
+                next.push_back(child);
+            }
+        }
+        level = std::move(next);
+    }
+
+    std::sort(ret.begin(), ret.end(), byName);
+    return ret;
+}
+
+} // namespace fty::asset
@@ -0,0 +1,95 @@
+/*  ====================================================================================================================
+    containment-tree.h - In-memory tree of asset locations
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include "asset-events.h"
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fty::db {
+class Connection;
+}
+
+namespace fty::asset {
+
+/// Which asset is located in which, kept in memory.
+/// Nodes are stored in a flat array, children of all the nodes in another one, each node owning a range of it.
+/// Changed assets are reloaded before the next use: the ones changed through this library and the ones announced on the
+/// asset streams. The tree also expires, for changes missed while the streams were not watched.
+class ContainmentTree
+{
+public:
+    /// Lifetime of the whole tree
+    static constexpr std::chrono::seconds MaxAge{60};
+
+    struct Node
+    {
+        uint32_t    id        = 0;
+        uint32_t    parentId  = 0;
+        uint16_t    typeId    = 0;
+        uint16_t    subTypeId = 0;
+        std::string status;
+        std::string name;
+    };
+
+    struct Filter
+    {
+        std::vector<uint16_t> types;    // any if empty
+        std::vector<uint16_t> subTypes; // any if empty
+        std::string           status;   // any if empty
+        uint32_t              depth = 0; // levels under the container, 0 for all
+    };
+
+    static ContainmentTree& instance();
+
+    /// Assets located (directly or not) in the container and matching the filter, sorted by internal name as the
+    /// database does. Nothing if the container is not in the tree (created elsewhere and not announced yet).
+    std::optional<std::vector<Node>> descendants(uint32_t container, const Filter& filter);
+
+private:
+    ContainmentTree();
+    void onEvent(const events::Event& event);
+    std::vector<std::string> resolveNames();
+    void refresh();
+    void set(Node&& node);
+    void link();
+
+    static std::vector<Node> load(fty::db::Connection& conn, const std::vector<uint32_t>& ids);
+
+private:
+    std::mutex                             m_loadMutex;
+    std::mutex                             m_mutex;
+    std::vector<Node>                      m_nodes;    // id 0 for removed assets
+    std::unordered_map<uint32_t, uint32_t> m_pos;      // position of the asset in m_nodes
+    std::vector<uint32_t>                  m_first;    // by position, first child in m_children, m_first[pos + 1] is the end
+    std::vector<uint32_t>                  m_children; // positions
+    std::set<uint32_t>                     m_dirty;
+    std::set<std::string>                  m_dirtyNames; // changes announced on the asset streams
+    bool                                   m_reset = true;
+    std::chrono::steady_clock::time_point  m_loaded;
+};
+
+} // namespace fty::asset
@@ -20,6 +20,14 @@
 */
 
 #include "create.h"
+#include "asset-events.h"
+#include "batch-read.h"
+#include "db-pool.h"
+#include "message-bus.h"
+#include "metrics.h"
+#include "rack-fit.h"
+#include "request-body.h"
+#include <asset/asset-db.h>
 #include <asset/asset-manager.h>
 #include <asset/asset-notifications.h>
 #include <cxxtools/jsondeserializer.h>
@@ -31,14 +39,24 @@ namespace fty::asset {
 
 unsigned Create::run()
 {
-    rest::User user(m_request);
+    static auto&     stats = metrics::endpoint("asset/create");
+    metrics::Request measure(stats, m_reply);
+
+    metrics::Scope permissions(metrics::Phase::Permissions);
+    rest::User     user(m_request);
     if (auto ret = checkPermissions(user.profile(), m_permissions); !ret) {
         throw rest::Error(ret.error());
     }
+    permissions.stop();
+
+    // reads of this client go to the primary database until the replica has the change
+    DbPool::Writer writer(user.login());
 
     cxxtools::SerializationInfo si;
     try {
-        std::stringstream          jsonIn(m_request.body());
+        metrics::Scope             parsing(metrics::Phase::Serialization);
+        const auto&                body = m_request.body();
+        BodyStream                 jsonIn(body);
         cxxtools::JsonDeserializer deserializer(jsonIn);
         deserializer.deserialize(si);
     } catch (const std::exception& e) {
@@ -46,17 +64,36 @@ unsigned Create::run()
         throw rest::errors::Internal(e.what());
     }
 
+    // units taken in a rack are checked against the rack index before creating, empty if the asset fits
+    auto misfit = [&](const cxxtools::SerializationInfo& doc) {
+        std::string reason;
+        if (auto placement = fit::requested(doc)) {
+            DbPool::Lease lease;
+            reason = fit::check(lease.connection(), *placement);
+        }
+        if (!reason.empty()) {
+            auditError(reason);
+        }
+        return reason;
+    };
+
     pack::StringList createdName;
     auto             validateAndAppend = [&](const uint32_t& id) {
-        auto createdAsset = fty::asset::db::idToNameExtName(id);
-
-        if (!createdAsset) {
-            auditError(createdAsset.error());
+        // name and parent in one read: with the parent, the indexes drop only what is placed in it
+        auto created = [&]() {
+            DbPool::Lease lease;
+            return batch::elements(lease.connection(), {id});
+        }();
+
+        auto element = created.find(id);
+        if (element == created.end()) {
+            auditError("Created asset {} not found"_tr, id);
             return;
         }
 
-        createdName.append(createdAsset->first);
-        auditInfo("Request CREATE asset id {} SUCCESS"_tr, createdAsset->first);
+        createdName.append(element->second.name);
+        events::publish({events::Type::Created, id, element->second.name, element->second.parentId});
+        auditInfo("Request CREATE asset id {} SUCCESS"_tr, element->second.name);
     };
 
     cxxtools::SerializationInfo assetsJsonList;
@@ -64,7 +101,15 @@ unsigned Create::run()
         assetsJsonList = si.getMember("assets");
 
         for (const auto& it : assetsJsonList) {
-            auto ret = AssetManager::createAsset(it, user.login());
+            metrics::Scope dbScope(metrics::Phase::Db);
+            if (!misfit(it).empty()) {
+                continue;
+            }
+            auto ret = [&]() {
+                metrics::DbCall call;
+                return AssetManager::createAsset(it, user.login());
+            }();
+            dbScope.stop();
             if (!ret) {
                 auditError(ret.error());
                 continue;
@@ -73,6 +118,7 @@ unsigned Create::run()
 
             std::ostringstream output;
 
+            metrics::Scope bus(metrics::Phase::Bus);
             if (auto names = db::idToNameExtName(*ret)) {
                 if (auto asset = AssetManager::getDto(names->first)) {
 
@@ -82,7 +128,7 @@ unsigned Create::run()
                     // full notification
                     if (auto json = pack::json::serialize(full, pack::Option::WithDefaults)) {
                         if (auto send =
-                                sendStreamNotification(notification::created::Topic::Full, notification::created::Subject::Full, *json);
+                                bus::sendStreamNotification(notification::created::Topic::Full, notification::created::Subject::Full, *json);
                             !send) {
                             log_error("Failed to send create notification: %s", send.error().c_str());
                         }
@@ -93,7 +139,7 @@ unsigned Create::run()
                     // light notification
                     if (auto json = pack::json::serialize(light, pack::Option::WithDefaults)) {
                         if (auto send =
-                                sendStreamNotification(notification::created::Topic::Light, notification::created::Subject::Light, *json);
+                                bus::sendStreamNotification(notification::created::Topic::Light, notification::created::Subject::Light, *json);
                             !send) {
                             log_error("Failed to send create light notification: %s", send.error().c_str());
                         }
@@ -108,12 +154,21 @@ unsigned Create::run()
             }
         }
     } else {
-        auto ret = AssetManager::createAsset(si, user.login());
+        metrics::Scope dbScope(metrics::Phase::Db);
+        if (auto reason = misfit(si); !reason.empty()) {
+            throw rest::errors::BadRequestDocument(reason);
+        }
+        auto ret = [&]() {
+            metrics::DbCall call;
+            return AssetManager::createAsset(si, user.login());
+        }();
+        dbScope.stop();
         if (!ret) {
             auditError(ret.error());
         } else {
             validateAndAppend(*ret);
 
+            metrics::Scope bus(metrics::Phase::Bus);
             if (auto names = db::idToNameExtName(*ret)) {
                 if (auto asset = AssetManager::getDto(names->first)) {
 
@@ -123,7 +178,7 @@ unsigned Create::run()
                     // full notification
                     if (auto json = pack::json::serialize(full, pack::Option::WithDefaults)) {
                         if (auto send =
-                                sendStreamNotification(notification::created::Topic::Full, notification::created::Subject::Full, *json);
+                                bus::sendStreamNotification(notification::created::Topic::Full, notification::created::Subject::Full, *json);
                             !send) {
                             log_error("Failed to send create notification: %s", send.error().c_str());
                         }
@@ -134,7 +189,7 @@ unsigned Create::run()
                     // light notification
                     if (auto json = pack::json::serialize(light, pack::Option::WithDefaults)) {
                         if (auto send =
-                                sendStreamNotification(notification::created::Topic::Light, notification::created::Subject::Light, *json);
+                                bus::sendStreamNotification(notification::created::Topic::Light, notification::created::Subject::Light, *json);
                             !send) {
                             log_error("Failed to send create light notification: %s", send.error().c_str());
                         }
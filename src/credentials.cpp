@@ -0,0 +1,70 @@
+/*  ====================================================================================================================
+    credentials.cpp - Incremental update of asset credential mappings
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "credentials.h"
+#include "batch-read.h"
+#include <fty_log.h>
+
+namespace fty::asset::credentials {
+
+static constexpr const char* EndpointPrefix = "endpoint.";
+
+static bool isEndpoint(const std::string& key)
+{
+    return key.compare(0, std::char_traits<char>::length(EndpointPrefix), EndpointPrefix) == 0;
+}
+
+std::map<std::string, Endpoints> stored(fty::db::Connection& conn, const std::vector<std::string>& inames)
+{
+    std::map<std::string, Endpoints> ret;
+    for (const auto& iname : inames) {
+        ret.emplace(iname, Endpoints{});
+    }
+    for (auto& [iname, endpoints] : batch::endpoints(conn, inames)) {
+        ret[iname] = std::move(endpoints);
+    }
+    return ret;
+}
+
+Endpoints requested(const ExtMap& ext)
+{
+    Endpoints ret;
+    for (const auto& [key, value] : ext) {
+        if (isEndpoint(key)) {
+            ret.emplace(key, value.first);
+        }
+    }
+    return ret;
+}
+
+void update(const std::string& iname, const std::optional<Endpoints>& before, const ExtMap& after)
+{
+    if (before && *before == requested(after)) {
+        logDebug("Endpoints of {} were not changed, CAM mappings are kept", iname);
+        return;
+    }
+
+    deleteMappings(iname);
+    auto credentialList = getCredentialMappings(after);
+    createMappings(iname, credentialList);
+}
+
+} // namespace fty::asset::credentials
@@ -0,0 +1,49 @@
+/*  ====================================================================================================================
+    credentials.h - Incremental update of asset credential mappings
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <asset/asset-cam.h>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace fty::db {
+class Connection;
+}
+
+namespace fty::asset::credentials {
+
+/// Endpoint ext attributes (endpoint.*) the CAM mappings of an asset are built from
+using Endpoints = std::map<std::string, std::string>;
+
+/// Endpoint attributes currently stored for given assets (internal names), fetched in one query per batch::Size assets.
+/// Assets without any endpoint attribute are reported with an empty set.
+std::map<std::string, Endpoints> stored(fty::db::Connection& conn, const std::vector<std::string>& inames);
+
+/// Endpoint attributes of a document sent by the client
+Endpoints requested(const ExtMap& ext);
+
+/// Recreates CAM mappings of the asset, but only if its endpoints differ from the stored ones.
+/// Without known previous state (nullopt) mappings are always recreated.
+void update(const std::string& iname, const std::optional<Endpoints>& before, const ExtMap& after);
+
+} // namespace fty::asset::credentials
@@ -0,0 +1,236 @@
+/*  ====================================================================================================================
+    db-pool.cpp - Pool of database connections
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "db-pool.h"
+#include "config.h"
+#include <exception>
+#include <fty_log.h>
+#include <stdexcept>
+
+namespace fty::asset {
+
+// connection leased by the current thread, shared by the nested leases
+static thread_local DbPool::Slot* currentSlot = nullptr;
+
+DbPool& DbPool::instance()
+{
+    static DbPool pool;
+    return pool;
+}
+
+size_t DbPool::open(Target target) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pools[size_t(target)].open;
+}
+
+DbPool::Slot::Slot(Target to)
+    : target(to)
+    , conn(to == Target::Replica ? fty::db::Connection(config::dbReplicaUrl()) : fty::db::Connection())
+{
+}
+
+bool DbPool::Slot::alive()
+{
+    try {
+        conn.prepare("SELECT 1").selectRow();
+        return true;
+    } catch (const std::exception& e) {
+        logDebug("Database connection lost: {}", e.what());
+        return false;
+    }
+}
+
+DbPool::Slot* DbPool::acquire(Target target)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto&                        pool = m_pools[size_t(target)];
+
+    auto available = [&]() {
+        return !pool.idle.empty() || pool.open < config::dbPoolSize();
+    };
+    if (!pool.free.wait_for(lock, config::dbPoolWait(), available)) {
+        throw std::runtime_error("No database connection available");
+    }
+
+    if (!pool.idle.empty()) {
+        auto slot = pool.idle.back().release();
+        pool.idle.pop_back();
+        return slot;
+    }
+
+    // connecting is done out of the lock, the place in the pool is reserved meanwhile
+    ++pool.open;
+    lock.unlock();
+    try {
+        return new Slot(target);
+    } catch (...) {
+        lock.lock();
+        --pool.open;
+        pool.free.notify_one();
+        throw;
+    }
+}
+
+void DbPool::release(Slot* slot, bool broken)
+{
+    std::unique_ptr<Slot> owned(slot);
+    auto&                 pool = m_pools[size_t(slot->target)];
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (broken) {
+            --pool.open;
+        } else {
+            pool.idle.push_back(std::move(owned));
+        }
+    }
+    pool.free.notify_one();
+}
+
+// =========================================================================================================================================
+
+DbPool::Target DbPool::readTarget(const std::string& client)
+{
+    if (config::dbReplicaUrl().empty()) {
+        return Target::Primary;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (auto it = m_writes.find(client); it != m_writes.end()) {
+        if (it->second.active || std::chrono::steady_clock::now() - it->second.last < config::readAfterWrite()) {
+            return Target::Primary;
+        }
+    }
+    return Target::Replica;
+}
+
+void DbPool::writing(const std::string& client, bool start)
+{
+    if (config::dbReplicaUrl().empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto                        now = std::chrono::steady_clock::now();
+
+    auto& writes = m_writes[client];
+    if (start) {
+        ++writes.active;
+    } else if (writes.active) {
+        --writes.active;
+    }
+    writes.last = now;
+
+    // clients which did not write for a while read from the replica again, no need to remember them
+    for (auto it = m_writes.begin(); it != m_writes.end();) {
+        if (!it->second.active && now - it->second.last >= config::readAfterWrite()) {
+            it = m_writes.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// =========================================================================================================================================
+
+DbPool::Lease::Lease(Target target)
+    : m_slot(currentSlot)
+    , m_parent(currentSlot)
+    , m_owner(false)
+    , m_exceptions(std::uncaught_exceptions())
+{
+    // a connection to the primary database also serves reads
+    if (currentSlot && (currentSlot->target == target || target == Target::Replica)) {
+        return;
+    }
+
+    if (target == Target::Replica) {
+        try {
+            m_slot = DbPool::instance().acquire(target);
+        } catch (const std::exception& e) {
+            logWarn("Replica database not available, reading from the primary one: {}", e.what());
+            target = Target::Primary;
+        }
+    }
+    if (target == Target::Primary) {
+        m_slot = DbPool::instance().acquire(target);
+    }
+
+    m_owner     = true;
+    currentSlot = m_slot;
+}
+
+DbPool::Lease::~Lease()
+{
+    if (!m_owner) {
+        return;
+    }
+    currentSlot = m_parent;
+
+    // a failure may come from the database or from the request, the connection is only replaced when it is lost
+    bool broken = std::uncaught_exceptions() > m_exceptions && !m_slot->alive();
+    if (broken) {
+        logDebug("Database connection dropped after a failure");
+    }
+    DbPool::instance().release(m_slot, broken);
+}
+
+fty::db::Connection& DbPool::Lease::connection()
+{
+    return m_slot->conn;
+}
+
+DbPool::Target DbPool::Lease::target() const
+{
+    return m_slot->target;
+}
+
+DbPool::Writer::Writer(const std::string& client)
+    : m_client(client)
+{
+    DbPool::instance().writing(m_client, true);
+}
+
+DbPool::Writer::~Writer()
+{
+    DbPool::instance().writing(m_client, false);
+}
+
+// =========================================================================================================================================
+
+fty::db::Statement prepareCached(fty::db::Connection& conn, const std::string& sql)
+{
+    auto slot = currentSlot;
+    if (!slot || &slot->conn != &conn) {
+        return conn.prepare(sql);
+    }
+
+    if (auto it = slot->statements.find(sql); it != slot->statements.end()) {
+        return it->second;
+    }
+
+    if (slot->statements.size() >= DbPool::MaxStatements) {
+        slot->statements.clear();
+    }
+    return slot->statements.emplace(sql, conn.prepare(sql)).first->second;
+}
+
+} // namespace fty::asset
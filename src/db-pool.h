@@ -0,0 +1,145 @@
+/*  ====================================================================================================================
+    db-pool.h - Pool of database connections
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <fty_common_db_connection.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fty::asset {
+
+/// Bounded pools of database connections shared by the handlers of the library, one to the primary database and one to
+/// the read-only replica when configured (FTY_ASSET_REST_DB_REPLICA_URL).
+/// A lease taken while the thread already holds one shares its connection, so all the lookups of a request go through
+/// one connection. Connections keep the statements prepared through them, see prepareCached().
+class DbPool
+{
+public:
+    enum class Target
+    {
+        Primary,
+        Replica,
+        Count
+    };
+
+    /// Pooled connection
+    struct Slot
+    {
+        explicit Slot(Target to);
+
+        /// True when the connection still answers
+        bool alive();
+
+        Target                                              target;
+        fty::db::Connection                                 conn;
+        std::unordered_map<std::string, fty::db::Statement> statements;
+    };
+
+    /// Connection of the pool, held until destroyed
+    class Lease
+    {
+    public:
+        /// Waits for a free connection, throws std::runtime_error if none gets free in time.
+        /// Replica leases fall back to the primary database when the replica cannot be reached.
+        /// Released during a failure, the connection is only dropped when it does not answer any more: errors of the
+        /// request itself (bad parameter, unknown asset...) keep it in the pool.
+        explicit Lease(Target target = Target::Primary);
+        ~Lease();
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        fty::db::Connection& connection();
+
+        /// Database the connection goes to, the primary one after a fallback
+        Target target() const;
+
+    private:
+        Slot* m_slot;
+        Slot* m_parent;
+        bool  m_owner;
+        int   m_exceptions;
+    };
+
+    /// Marks the client as writing while alive: its reads go to the primary database until the replica is expected to
+    /// have caught up (FTY_ASSET_REST_READ_AFTER_WRITE_MS after the write)
+    class Writer
+    {
+    public:
+        explicit Writer(const std::string& client);
+        ~Writer();
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+    private:
+        std::string m_client;
+    };
+
+    static DbPool& instance();
+
+    /// Where the reads of the client go: the replica if configured, unless the client wrote recently
+    Target readTarget(const std::string& client);
+
+    /// Connections open, idle ones included
+    size_t open(Target target = Target::Primary) const;
+
+private:
+    // statements kept per connection, the cache is emptied when full
+    static constexpr size_t MaxStatements = 64;
+
+    struct Pool
+    {
+        std::condition_variable            free;
+        std::vector<std::unique_ptr<Slot>> idle;
+        size_t                             open = 0;
+    };
+
+    struct Writes
+    {
+        size_t                                active = 0;
+        std::chrono::steady_clock::time_point last;
+    };
+
+    DbPool() = default;
+    Slot* acquire(Target target);
+    void  release(Slot* slot, bool broken);
+    void  writing(const std::string& client, bool start);
+
+    friend fty::db::Statement prepareCached(fty::db::Connection& conn, const std::string& sql);
+
+private:
+    mutable std::mutex                      m_mutex;
+    std::array<Pool, size_t(Target::Count)> m_pools;
+    std::map<std::string, Writes>           m_writes;
+};
+
+/// Statement prepared on the connection, taken from the cache of the connection when it is leased from the pool
+fty::db::Statement prepareCached(fty::db::Connection& conn, const std::string& sql);
+
+} // namespace fty::asset
@@ -1,6 +1,13 @@
 #include "delete.h"
+#include "admission.h"
+#include "asset-events.h"
+#include "batch-read.h"
+#include "db-pool.h"
+#include "message-bus.h"
+#include "metrics.h"
 #include <asset/asset-configure-inform.h>
 #include <asset/asset-db.h>
+#include <asset/asset-db2.h>
 #include <asset/asset-manager.h>
 #include <asset/asset-notifications.h>
 #include <fty/rest/audit-log.h>
@@ -14,10 +21,18 @@ namespace fty::asset {
 
 unsigned Delete::run()
 {
-    rest::User user(m_request);
+    static auto&     stats = metrics::endpoint("asset/delete");
+    metrics::Request measure(stats, m_reply);
+
+    metrics::Scope permissions(metrics::Phase::Permissions);
+    rest::User     user(m_request);
     if (auto ret = checkPermissions(user.profile(), m_permissions); !ret) {
         throw rest::Error(ret.error());
     }
+    permissions.stop();
+
+    // reads of this client go to the primary database until the replica has the change
+    DbPool::Writer writer(user.login());
 
     // sanity check
     Expected<std::string> id  = m_request.queryArg<std::string>("id");
@@ -28,8 +43,19 @@ unsigned Delete::run()
     }
 
     if (id) {
+        // lookup, document for the notification, delete
+        measure.budget(3);
+        measure.param("id", *id);
         return deleteOneAsset(*id);
     }
+    measure.param("ids", *ids);
+
+    // bulk delete is a heavy request
+    Admission::Ticket ticket(Admission::Class::Delete);
+    if (!ticket.admitted()) {
+        m_reply.setHeader("Retry-After:", std::to_string(ticket.retryAfter()));
+        return HTTP_SERVICE_UNAVAILABLE;
+    }
     return deleteAssets(*ids);
 }
 
@@ -40,24 +66,39 @@ unsigned Delete::deleteOneAsset(const std::string& idStr)
         throw rest::errors::RequestParamBad("id", idStr, "valid asset name"_tr);
     }
 
-    Expected<uint32_t> dbid = db::nameToAssetId(idStr);
+    metrics::Scope dbScope(metrics::Phase::Db);
+
+    auto dbid = [&]() {
+        DbPool::Lease   lease;
+        metrics::DbCall call;
+        return db::asset::nameToAssetId(lease.connection(), idStr);
+    }();
     if (!dbid) {
         auditError("Request DELETE asset id {} FAILED: {}"_tr, idStr, dbid.error());
         throw rest::errors::DbErr(dbid.error());
     }
 
-    auto dto = AssetManager::getDto(idStr);
+    auto dto = [&]() {
+        metrics::DbCall call;
+        return AssetManager::getDto(idStr);
+    }();
 
-    auto res = AssetManager::deleteAsset(*dbid);
+    auto res = [&]() {
+        metrics::DbCall call;
+        return AssetManager::deleteAsset(*dbid);
+    }();
     if (!res) {
         logError(res.error());
         std::string reason = "Asset is in use, remove children/power source links first."_tr;
         auditError("Request DELETE asset id {} FAILED"_tr, idStr);
         throw rest::errors::DataConflict(idStr, reason);
     }
+    events::publish({events::Type::Deleted, res->id, idStr, res->parentId});
+    dbScope.stop();
 
-    std::string agent_name = generateMlmClientId("web.asset_delete");
-    if (auto ret = sendConfigure(*res, persist::asset_operation::DELETE, agent_name)) {
+    metrics::Scope bus(metrics::Phase::Bus);
+    std::string    agent_name = generateMlmClientId("web.asset_delete");
+    if (auto ret = bus::sendConfigure(*res, persist::asset_operation::DELETE, agent_name)) {
         m_reply << "{}";
         auditInfo("Request DELETE asset id {} SUCCESS", idStr);
 
@@ -68,7 +109,7 @@ unsigned Delete::deleteOneAsset(const std::string& idStr)
 
             // full notification
             if (auto json = pack::json::serialize(full, pack::Option::WithDefaults)) {
-                if (auto send = sendStreamNotification(notification::deleted::Topic::Full, notification::deleted::Subject::Full, *json);
+                if (auto send = bus::sendStreamNotification(notification::deleted::Topic::Full, notification::deleted::Subject::Full, *json);
                     !send) {
                     log_error("Failed to send delete notification: %s", send.error().c_str());
                 }
@@ -78,7 +119,7 @@ unsigned Delete::deleteOneAsset(const std::string& idStr)
 
             // light notification
             if (auto json = pack::json::serialize(light, pack::Option::WithDefaults)) {
-                if (auto send = sendStreamNotification(notification::deleted::Topic::Light, notification::deleted::Subject::Light, *json);
+                if (auto send = bus::sendStreamNotification(notification::deleted::Topic::Light, notification::deleted::Subject::Light, *json);
                     !send) {
                     log_error("Failed to send delete light notification: %s", send.error().c_str());
                 }
@@ -120,36 +161,58 @@ unsigned Delete::deleteAssets(const std::string& idsStr)
         }
     }
 
+    // lookup of all the assets, then the document of each one for the full notification (the library reads them one
+    // by one) and one delete
+    if (auto measure = metrics::Request::current()) {
+        measure->budget(batch::statements(ids.size()) + ids.size() + 1);
+    }
+
+    metrics::Scope dbScope(metrics::Phase::Db);
+
+    auto found = [&]() {
+        DbPool::Lease lease;
+        return batch::ids(lease.connection(), ids);
+    }();
+
     std::map<uint32_t, std::string> dbIds;
     for (const auto& id : ids) {
-        if (auto dbid = db::nameToAssetId(id)) {
-            dbIds.emplace(*dbid, id);
-            if (auto dto = AssetManager::getDto(id)) {
-                dtos[id] = *dto;
-            } else {
-                log_error("Failed to get asset DTO: %s", dto.error().message().c_str());
-            }
-        } else {
-            logError(dbid.error());
+        auto dbid = found.find(id);
+        if (dbid == found.end()) {
+            logError("Element {} not found", id);
             auditError("Request DELETE asset id {} FAILED", id);
             throw rest::errors::RequestParamBad("ids", idsStr, "valid asset name"_tr);
         }
+        dbIds.emplace(dbid->second, id);
+
+        metrics::DbCall call;
+        if (auto dto = AssetManager::getDto(id)) {
+            dtos[id] = *dto;
+        } else {
+            log_error("Failed to get asset DTO: %s", dto.error().message().c_str());
+        }
     }
 
-    auto result = AssetManager::deleteAsset(dbIds);
+    auto result = [&]() {
+        metrics::DbCall call;
+        return AssetManager::deleteAsset(dbIds);
+    }();
+    dbScope.stop();
+
+    metrics::Scope bus(metrics::Phase::Bus);
 
     bool someAreOk = false;
     for (const auto& [name, asset] : result) {
         if (asset) {
             someAreOk = true;
             auditInfo("Request DELETE asset id {} SUCCESS", asset->id);
+            events::publish({events::Type::Deleted, asset->id, name, asset->parentId});
             if (auto found = dtos.find(name); found != dtos.end()) {
 
                 notification::deleted::PayloadFull full = found->second;
 
                 // full notification
                 if (auto json = pack::json::serialize(full, pack::Option::WithDefaults)) {
-                    if (auto send = sendStreamNotification(notification::deleted::Topic::Full, notification::deleted::Subject::Full, *json);
+                    if (auto send = bus::sendStreamNotification(notification::deleted::Topic::Full, notification::deleted::Subject::Full, *json);
                         !send) {
                         log_error("Failed to send delete notification: %s", send.error().c_str());
                     }
@@ -162,7 +225,7 @@ unsigned Delete::deleteAssets(const std::string& idsStr)
             light = name;
             // light notification
             if (auto json = pack::json::serialize(light, pack::Option::WithDefaults)) {
-                if (auto send = sendStreamNotification(notification::deleted::Topic::Light, notification::deleted::Subject::Light, *json);
+                if (auto send = bus::sendStreamNotification(notification::deleted::Topic::Light, notification::deleted::Subject::Light, *json);
                     !send) {
                     log_error("Failed to send delete light notification: %s", send.error().c_str());
                 }
@@ -182,7 +245,7 @@ unsigned Delete::deleteAssets(const std::string& idsStr)
         retVal.status = asset ? "OK" : "ERROR";
         retVal.asset  = name;
         if (asset) {
-            sendConfigure(*asset, persist::asset_operation::DELETE, agent_name);
+            bus::sendConfigure(*asset, persist::asset_operation::DELETE, agent_name);
         } else {
             rest::json(asset.error(), retVal.reason);
         }
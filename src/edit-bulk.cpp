@@ -0,0 +1,436 @@
+/*  ====================================================================================================================
+    edit-bulk.cpp - Implementation of bulk PUT (update) operation on a list of assets
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "edit-bulk.h"
+#include "activation-queue.h"
+#include "asset-events.h"
+#include "credentials.h"
+#include "db-pool.h"
+#include "message-bus.h"
+#include "metrics.h"
+#include "request-body.h"
+#include <algorithm>
+#include <asset/asset-cam.h>
+#include <asset/asset-configure-inform.h>
+#include <asset/asset-helpers.h>
+#include <asset/asset-import.h>
+#include <asset/asset-manager.h>
+#include <asset/asset-notifications.h>
+#include <asset/csv.h>
+#include <cxxtools/jsondeserializer.h>
+#include <fty/rest/audit-log.h>
+#include <fty/rest/component.h>
+#include <fty_common.h>
+#include <fty_common_asset.h>
+#include <fty_common_db_connection.h>
+#include <fty_common_mlm.h>
+
+namespace fty::asset {
+
+struct BulkStatus : public pack::Node
+{
+    pack::String asset  = FIELD("asset");
+    pack::String status = FIELD("status");
+    pack::String reason = FIELD("reason");
+
+    using pack::Node::Node;
+    META(BulkStatus, asset, status, reason);
+};
+
+// One requested change: document as sent by the client and its csv representation
+struct BulkItem
+{
+    std::string                 id;
+    cxxtools::SerializationInfo si;
+    CsvMap                      cm;
+    std::optional<Dto>          before;
+    std::shared_future<void>    activated;
+    bool                        updated = false;
+    std::string                 error;
+    std::string                 warning; // updated, but something after it failed
+};
+
+// =========================================================================================================================================
+
+static std::string csvQuote(const std::string& value)
+{
+    std::string out = "\"";
+    for (char ch : value) {
+        if (ch == '"') {
+            out += '"';
+        }
+        out += ch;
+    }
+    out += '"';
+    return out;
+}
+
+// Builds one csv document out of single row documents sharing the same titles, so they are imported at once
+static CsvMap mergeRows(const std::vector<BulkItem*>& items)
+{
+    const auto titles = items.front()->cm.getTitles();
+
+    std::stringstream csv;
+
+    bool first = true;
+    for (const auto& title : titles) {
+        csv << (first ? "" : ",") << csvQuote(title);
+        first = false;
+    }
+    csv << "\n";
+
+    for (const auto* item : items) {
+        first = true;
+        for (const auto& title : titles) {
+            csv << (first ? "" : ",") << csvQuote(item->cm.get(1, title));
+            first = false;
+        }
+        csv << "\n";
+    }
+
+    CsvMap cm = CsvMap_from_istream(csv);
+    cm.deserialize();
+    return cm;
+}
+
+static void prepareItem(BulkItem& item)
+{
+    auto siId = item.si.findMember("id");
+    if (!siId) {
+        item.error = "Asset id is not set"_tr;
+        return;
+    }
+    *siId >>= item.id;
+
+    if (!persist::is_ok_name(item.id.c_str())) {
+        item.error = "Asset id is not valid"_tr;
+        return;
+    }
+
+    std::string status;
+    std::string type;
+    if (auto member = item.si.findMember("status")) {
+        *member >>= status;
+    }
+    if (auto member = item.si.findMember("type")) {
+        *member >>= type;
+    }
+
+    if (type.empty()) {
+        item.error = "Request parameter 'type' is required"_tr;
+        return;
+    }
+
+    if (status == "nonactive" && (item.id == "rackcontroller-0" || persist::is_container(type))) {
+        logDebug("Element {} cannot be inactivated.", item.id);
+        item.error = "Inactivation of this asset is forbidden"_tr;
+        return;
+    }
+
+    try {
+        item.cm = CsvMap_from_serialization_info(item.si);
+    } catch (const std::exception& e) {
+        item.error = e.what();
+        return;
+    }
+
+    if (item.cm.cols() == 0 || item.cm.rows() != 2) {
+        item.error = "Cannot import empty document."_tr;
+        return;
+    }
+
+    if (auto before = AssetManager::getDto(item.id)) {
+        item.before = *before;
+    } else {
+        log_error("Failed to get asset DTO: %s", before.error().message().c_str());
+    }
+}
+
+static void notifyUpdated(const Dto& before, const Dto& after)
+{
+    notification::updated::PayloadFull full;
+    full.before                               = before;
+    full.after                                = after;
+    notification::updated::PayloadLight light = after.name;
+
+    // full notification
+    if (auto json = pack::json::serialize(full, pack::Option::WithDefaults)) {
+        if (auto send = bus::sendStreamNotification(notification::updated::Topic::Full, notification::updated::Subject::Full, *json); !send) {
+            log_error("Failed to send update notification: %s", send.error().c_str());
+        }
+    } else {
+        log_error("Failed to serialize notification payload: %s", json.error().c_str());
+    }
+
+    // light notification
+    if (auto json = pack::json::serialize(light, pack::Option::WithDefaults)) {
+        if (auto send = bus::sendStreamNotification(notification::updated::Topic::Light, notification::updated::Subject::Light, *json);
+            !send) {
+            log_error("Failed to send update light notification: %s", send.error().c_str());
+        }
+    } else {
+        log_error("Failed to serialize notification light payload: %s", json.error().c_str());
+    }
+}
+
+// =========================================================================================================================================
+
+unsigned EditBulk::run()
+{
+    static auto&     stats = metrics::endpoint("asset/edit-bulk");
+    metrics::Request measure(stats, m_reply);
+
+    metrics::Scope permissions(metrics::Phase::Permissions);
+    rest::User     user(m_request);
+    if (auto ret = checkPermissions(user.profile(), m_permissions); !ret) {
+        throw rest::Error(ret.error());
+    }
+    permissions.stop();
+
+    // reads of this client go to the primary database until the replica has the change
+    DbPool::Writer writer(user.login());
+
+    if (m_request.type() != rest::Request::Type::Put) {
+        throw rest::errors::MethodNotAllowed(m_request.typeStr());
+    }
+
+    cxxtools::SerializationInfo si;
+    try {
+        metrics::Scope             parsing(metrics::Phase::Serialization);
+        const auto&                body = m_request.body();
+        BodyStream                 input(body);
+        cxxtools::JsonDeserializer deserializer(input);
+        deserializer.deserialize(si);
+    } catch (const std::exception& e) {
+        auditError("Request UPDATE assets FAILED: {}"_tr, e.what());
+        throw rest::errors::BadRequestDocument(e.what());
+    }
+
+    auto list = si.findMember("assets");
+    if (!list || list->category() != cxxtools::SerializationInfo::Category::Array) {
+        auditError("Request UPDATE assets FAILED: {}"_tr, "List of assets is not set"_tr);
+        throw rest::errors::RequestParamRequired("assets");
+    }
+
+    metrics::Scope dbScope(metrics::Phase::Db);
+
+    std::vector<BulkItem> items(list->memberCount());
+    {
+        size_t index = 0;
+        for (const auto& it : *list) {
+            items[index].si = it;
+            prepareItem(items[index]);
+            ++index;
+        }
+    }
+
+    // endpoints before the change for all the assets at once, CAM mappings are touched only if they differ
+    std::optional<std::map<std::string, credentials::Endpoints>> endpoints;
+    try {
+        std::vector<std::string> inames;
+        for (const auto& item : items) {
+            if (item.error.empty()) {
+                inames.push_back(item.id);
+            }
+        }
+        DbPool::Lease        lease;
+        fty::db::Connection& conn = lease.connection();
+        endpoints = credentials::stored(conn, inames);
+    } catch (const std::exception& e) {
+        logError("Failed to read endpoints: {}", e.what());
+    }
+
+    std::string updateTs;
+    {
+        std::time_t timestamp = std::time(nullptr);
+        char        timeString[100];
+        if (std::strftime(timeString, sizeof(timeString), "%FT%T%z", std::localtime(&timestamp))) {
+            updateTs = timeString;
+        }
+    }
+
+    // The batch is imported at once or not at all. The import of the library opens its own connections and cannot run
+    // in a transaction of this handler: an invalid asset, or documents with different columns, which would need
+    // several imports, reject the whole batch before anything is written.
+    std::vector<BulkItem*> batch;
+    for (auto& item : items) {
+        batch.push_back(&item);
+    }
+
+    bool valid = std::all_of(items.begin(), items.end(), [](const BulkItem& item) {
+        return item.error.empty();
+    });
+    if (!valid) {
+        for (auto& item : items) {
+            if (item.error.empty()) {
+                item.error = "Not updated, other assets of the request are not valid"_tr;
+            }
+        }
+    } else if (!items.empty()) {
+        const auto titles = items.front().cm.getTitles();
+        for (const auto& item : items) {
+            if (item.cm.getTitles() != titles) {
+                auditError("Request UPDATE assets FAILED: {}"_tr, "assets with different fields"_tr);
+                throw rest::errors::RequestParamBad("assets", "assets with different fields"_tr, "assets with the same fields"_tr);
+            }
+        }
+    }
+
+    std::vector<std::pair<db::AssetElement, persist::asset_operation>> configure;
+
+    if (valid && !batch.empty()) {
+        logDebug("starting bulk load of {} assets", batch.size());
+
+        std::optional<CsvMap> cm;
+        try {
+            cm = mergeRows(batch);
+            cm->setUpdateUser(user.login());
+            if (!updateTs.empty()) {
+                cm->setUpdateTs(updateTs);
+            }
+        } catch (const std::exception& e) {
+            cm.reset();
+            for (auto* item : batch) {
+                item->error = e.what();
+            }
+        }
+
+        if (cm) {
+            Import import(*cm);
+            if (auto res = import.process(true); !res) {
+                for (auto* item : batch) {
+                    item->error = res.error();
+                }
+            } else {
+                const auto& imported = import.items();
+                for (size_t row = 1; row <= batch.size(); ++row) {
+                    auto* item = batch[row - 1];
+                    if (auto found = imported.find(row); found == imported.end()) {
+                        item->error = "Import failed"_tr;
+                    } else if (!found->second) {
+                        item->error = found->second.error();
+                    } else {
+                        item->updated = true;
+                        configure.emplace_back(*found->second, import.operation());
+                    }
+                }
+            }
+        }
+    }
+
+    dbScope.stop();
+
+    metrics::Scope bus(metrics::Phase::Bus);
+    if (!configure.empty()) {
+        // this code can be executed in multiple threads -> agent's name should
+        // be unique at the every moment
+        std::string agent_name = generateMlmClientId("web.asset_put_bulk");
+        // assets are already changed in the database, the client gets their statuses anyway
+        if (auto sent = bus::sendConfigure(configure, agent_name); !sent) {
+            logError(sent.error());
+            for (auto& item : items) {
+                if (item.updated) {
+                    item.warning = "Asset was updated, but the agents were not informed: {}"_tr.format(sent.error());
+                }
+            }
+        }
+
+        for (const auto& [element, operation] : configure) {
+            events::publish({events::Type::Updated, element.id, element.name, element.parentId});
+        }
+    }
+
+    pack::ObjectList<BulkStatus> result;
+    bool                         someAreOk = false;
+
+    for (auto& item : items) {
+        if (item.updated) {
+            try {
+                ExtMap map;
+                getExtMapFromSi(item.si, map);
+
+                std::optional<credentials::Endpoints> before;
+                if (endpoints) {
+                    before = (*endpoints)[item.id];
+                }
+                credentials::update(item.id, before, map);
+            } catch (const std::exception& e) {
+                log_error("Failed to update CAM: %s", e.what());
+            }
+
+            if (auto after = AssetManager::getDto(item.id); item.before && after) {
+                notifyUpdated(*item.before, *after);
+            } else if (!after) {
+                log_error("Failed to get asset DTO: %s", after.error().message().c_str());
+            }
+
+            try {
+                fty::FullAsset asset(item.si);
+                item.si >>= asset;
+
+                if (asset.getTypeString() == "device") {
+                    item.activated = ActivationQueue::instance().push(asset);
+                }
+            } catch (const std::exception& e) {
+                item.error = e.what();
+            }
+        }
+    }
+
+    // all the devices are queued at this point, so they are sent to licensing in as few batches as possible
+    for (auto& item : items) {
+        if (item.activated.valid()) {
+            try {
+                item.activated.get();
+            } catch (const std::exception& e) {
+                item.error = e.what();
+            }
+        }
+
+        auto& status = result.append();
+        status.asset = item.id;
+        if (item.updated && item.error.empty()) {
+            someAreOk     = true;
+            status.status = "OK";
+            status.reason = item.warning;
+            auditInfo("Request CREATE OR UPDATE asset id {} SUCCESS"_tr, item.id);
+        } else {
+            status.status = "ERROR";
+            status.reason = item.error;
+            auditError("Request CREATE OR UPDATE asset id {} FAILED: {}"_tr, item.id, item.error);
+        }
+    }
+
+    bus.stop();
+
+    metrics::Scope serialization(metrics::Phase::Serialization);
+    m_reply << *pack::json::serialize(result);
+
+    if (!someAreOk) {
+        return HTTP_BAD_REQUEST;
+    }
+
+    return HTTP_OK;
+}
+
+} // namespace fty::asset
+
+registerHandler(fty::asset::EditBulk)
@@ -1,6 +1,15 @@
 #include "edit.h"
+#include "activation-queue.h"
+#include "asset-events.h"
+#include "credentials.h"
+#include "db-pool.h"
+#include "message-bus.h"
+#include "metrics.h"
+#include "rack-fit.h"
+#include "request-body.h"
 #include <asset/asset-cam.h>
 #include <asset/asset-configure-inform.h>
+#include <asset/asset-db.h>
 #include <asset/asset-import.h>
 #include <asset/asset-manager.h>
 #include <asset/asset-notifications.h>
@@ -12,6 +21,7 @@
 //#include <fty_asset_activator.h>
 #include <asset/asset-helpers.h>
 #include <fty_common_asset.h>
+#include <fty_common_db_connection.h>
 #include <fty_common_mlm.h>
 
 namespace fty::asset {
@@ -20,10 +30,18 @@ namespace fty::asset {
 
 unsigned Edit::run()
 {
-    rest::User user(m_request);
+    static auto&     stats = metrics::endpoint("asset/edit");
+    metrics::Request measure(stats, m_reply);
+
+    metrics::Scope permissions(metrics::Phase::Permissions);
+    rest::User     user(m_request);
     if (auto ret = checkPermissions(user.profile(), m_permissions); !ret) {
         throw rest::Error(ret.error());
     }
+    permissions.stop();
+
+    // reads of this client go to the primary database until the replica has the change
+    DbPool::Writer writer(user.login());
 
     Expected<std::string> id = m_request.queryArg<std::string>("id");
     if (!id) {
@@ -36,12 +54,31 @@ unsigned Edit::run()
         throw rest::errors::RequestParamBad("id", *id, "Valid id"_tr);
     }
 
-    auto before = AssetManager::getDto(*id);
+    metrics::Scope dbScope(metrics::Phase::Db);
+
+    measure.param("id", *id);
+
+    auto before = [&]() {
+        metrics::DbCall call;
+        return AssetManager::getDto(*id);
+    }();
+
+    // endpoints before the change, CAM mappings are touched only if they differ
+    std::optional<credentials::Endpoints> endpoints;
+    try {
+        DbPool::Lease        lease;
+        fty::db::Connection& conn = lease.connection();
+        endpoints = credentials::stored(conn, {*id})[*id];
+    } catch (const std::exception& e) {
+        logError("Failed to read endpoints of {}: {}", *id, e.what());
+    }
+    dbScope.stop();
 
-    std::string                 asset_json(m_request.body());
     cxxtools::SerializationInfo si;
     try {
-        std::stringstream          input(asset_json, std::ios_base::in);
+        metrics::Scope             parsing(metrics::Phase::Serialization);
+        const auto&                body = m_request.body();
+        BodyStream                 input(body);
         cxxtools::JsonDeserializer deserializer(input);
         deserializer.deserialize(si);
         auto        si_id = si.findMember("id");
@@ -97,22 +134,38 @@ unsigned Edit::run()
         throw rest::errors::RequestParamRequired("type"_tr);
     }
 
+    // units taken in a rack are checked against the rack index before importing
+    if (auto placement = fit::requested(si)) {
+        metrics::Scope fitScope(metrics::Phase::Db);
+        DbPool::Lease  lease;
+        if (auto reason = fit::check(lease.connection(), *placement, *id); !reason.empty()) {
+            auditError("Request CREATE OR UPDATE asset id {} FAILED: {}"_tr, *id, reason);
+            throw rest::errors::BadRequestDocument(reason);
+        }
+    }
+
     logDebug("starting load");
-    Import import(cm);
-    if (auto res = import.process(true)) {
+    metrics::Scope importScope(metrics::Phase::Db);
+    Import         import(cm);
+    auto           res = import.process(true);
+    importScope.stop();
+    if (res) {
         const auto& imported = import.items();
         if (imported.find(1) == imported.end()) {
             throw rest::errors::Internal("Request CREATE OR UPDATE asset id {} FAILED"_tr.format(*id));
         }
 
         if (imported.at(1)) {
+            metrics::Scope bus(metrics::Phase::Bus);
+
             // this code can be executed in multiple threads -> agent's name should
             // be unique at the every moment
             std::string agent_name = generateMlmClientId("web.asset_put");
-            if (auto sent = sendConfigure(*(imported.at(1)), import.operation(), agent_name); !sent) {
+            if (auto sent = bus::sendConfigure(*(imported.at(1)), import.operation(), agent_name); !sent) {
                 logError(sent.error());
                 throw rest::errors::Internal(sent.error());
             }
+            events::publish({events::Type::Updated, imported.at(1)->id, *id, imported.at(1)->parentId});
 
             // no unexpected errors was detected
             // process results
@@ -129,10 +182,7 @@ unsigned Edit::run()
                 getExtMapFromSi(si, map);
 
                 const auto& assetIname = ret.value().first;
-
-                deleteMappings(assetIname);
-                auto credentialList = getCredentialMappings(map);
-                createMappings(assetIname, credentialList);
+                credentials::update(assetIname, endpoints, map);
             } catch (const std::exception& e) {
                 log_error("Failed to update CAM: %s", e.what());
             }
@@ -146,7 +196,7 @@ unsigned Edit::run()
 
                 // full notification
                 if (auto json = pack::json::serialize(full, pack::Option::WithDefaults)) {
-                    if (auto send = sendStreamNotification(notification::updated::Topic::Full, notification::updated::Subject::Full, *json);
+                    if (auto send = bus::sendStreamNotification(notification::updated::Topic::Full, notification::updated::Subject::Full, *json);
                         !send) {
                         log_error("Failed to send update notification: %s", send.error().c_str());
                     }
@@ -157,7 +207,7 @@ unsigned Edit::run()
                 // light notification
                 if (auto json = pack::json::serialize(light, pack::Option::WithDefaults)) {
                     if (auto send =
-                            sendStreamNotification(notification::updated::Topic::Light, notification::updated::Subject::Light, *json);
+                            bus::sendStreamNotification(notification::updated::Topic::Light, notification::updated::Subject::Light, *json);
                         !send) {
                         log_error("Failed to send update light notification: %s", send.error().c_str());
                     }
@@ -178,13 +228,11 @@ unsigned Edit::run()
                 si >>= asset;
 
                 if (asset.getTypeString() == "device") {
-                    if (asset.getStatusString() == "active") {
-                        if (!activation::isActivable(asset)) {
-                            throw std::runtime_error("Asset cannot be activated"_tr);
-                        }
-                        activation::activate(asset);
-                    } else {
-                        activation::deactivate(asset);
+                    // done in the background, the workers log failures. With wait_activation=true the reply waits for
+                    // it and reports the licensing error of this asset.
+                    auto activated = ActivationQueue::instance().push(asset);
+                    if (auto wait = m_request.queryArg<bool>("wait_activation"); wait && *wait) {
+                        activated.get();
                     }
                 }
             } catch (const std::exception& e) {
@@ -1,30 +1,311 @@
 #include "export.h"
+#include "admission.h"
+#include "config.h"
+#include "db-pool.h"
+#include "metrics.h"
 #include <asset/asset-db.h>
+#include <asset/asset-db2.h>
 #include <asset/asset-manager.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <exception>
 #include <fty/rest/component.h>
+#include <fty/string-utils.h>
 #include <fty_common_asset_types.h>
+#include <fty_log.h>
+#include <map>
 #include <regex>
+#include <set>
+#include <string_view>
 #include <iomanip>
+#include <thread>
 
 namespace fty::asset {
 
+static const std::string Bom = "\xef\xbb\xbf";
+
+// One datacenter of an export of several ones, filled by a worker
+struct DcExport
+{
+    db::AssetElement         dc;
+    std::string              name;
+    std::string              csv;
+    std::string              error;
+    std::exception_ptr       exception;
+    metrics::Clock::duration namesTime{};
+    metrics::Clock::duration exportTime{};
+};
+
+// escape special characters
+static std::string fileName(const std::string& extName)
+{
+    return std::regex_replace(extName, std::regex("( |\t)"), "_");
+}
+
+// file names of an archive have at most 100 characters, the time stamp must be kept. The name is not cut within an
+// UTF-8 character, names which are the same once escaped and cut are told apart by a number.
+static std::string memberName(const std::string& name, const std::string& time, size_t number)
+{
+    std::string suffix = number ? "_" + std::to_string(number) : std::string();
+    size_t      size   = std::min(name.size(), 60 - suffix.size());
+    while (size > 0 && size < name.size() && (static_cast<unsigned char>(name[size]) & 0xc0) == 0x80) {
+        --size;
+    }
+    return "asset_export_" + name.substr(0, size) + suffix + "_" + time + ".csv";
+}
+
+// Exports the datacenters on at most FTY_ASSET_REST_EXPORT_WORKERS threads, the calling one included. Queries are
+// timed here and counted by the caller: the request statistics belong to the calling thread. Each worker leases its own
+// connection, the calling thread shares the one it holds.
+static void exportDatacenters(std::vector<DcExport>& list, DbPool::Target target)
+{
+    std::atomic<size_t> next{0};
+
+    auto work = [&]() {
+        for (size_t i = next++; i < list.size(); i = next++) {
+            auto& item = list[i];
+            try {
+                DbPool::Lease lease(target);
+                auto          start = metrics::Clock::now();
+                auto          names = db::asset::idToNameExtName(lease.connection(), item.dc.id);
+                if (!names) {
+                    item.error = "Database failure"_tr;
+                    continue;
+                }
+                item.name = fileName(names->second);
+
+                auto exported  = metrics::Clock::now();
+                item.namesTime = exported - start;
+
+                auto ret        = AssetManager::exportCsv(item.dc);
+                item.exportTime = metrics::Clock::now() - exported;
+                if (!ret) {
+                    item.error = ret.error();
+                    continue;
+                }
+                item.csv = std::move(*ret);
+            } catch (...) {
+                item.exception = std::current_exception();
+            }
+        }
+    };
+
+    size_t                   workers = std::min(config::exportWorkers(), list.size());
+    std::vector<std::thread> threads;
+    try {
+        for (size_t i = 1; i < workers; ++i) {
+            threads.emplace_back(work);
+        }
+    } catch (const std::exception& e) {
+        // the workers started are joined below, they share the datacenters with this thread
+        logWarn("Export on {} thread(s) only: {}", threads.size() + 1, e.what());
+    }
+    work();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// =========================================================================================================================================
+
+// Next record of a csv document from pos, false at its end. Quoted fields may hold separators and new lines.
+static bool csvRecord(const std::string& csv, size_t& pos, std::vector<std::string>& record)
+{
+    record.clear();
+    if (pos == 0 && csv.compare(0, Bom.size(), Bom) == 0) {
+        pos = Bom.size();
+    }
+    if (pos >= csv.size()) {
+        return false;
+    }
+
+    std::string field;
+    bool        quoted = false;
+    for (; pos < csv.size(); ++pos) {
+        char ch = csv[pos];
+        if (quoted) {
+            if (ch != '"') {
+                field += ch;
+            } else if (pos + 1 < csv.size() && csv[pos + 1] == '"') {
+                field += '"';
+                ++pos;
+            } else {
+                quoted = false;
+            }
+        } else if (ch == '"') {
+            quoted = true;
+        } else if (ch == ',') {
+            record.push_back(std::move(field));
+            field.clear();
+        } else if (ch == '\n') {
+            ++pos;
+            record.push_back(std::move(field));
+            return true;
+        } else if (ch != '\r') {
+            field += ch;
+        }
+    }
+    // last record without new line
+    if (field.empty() && record.empty()) {
+        return false;
+    }
+    record.push_back(std::move(field));
+    return true;
+}
+
+static std::string csvField(const std::string& value)
+{
+    if (value.find_first_of(",\"\r\n") == std::string::npos) {
+        return value;
+    }
+
+    std::string out = "\"";
+    for (char ch : value) {
+        if (ch == '"') {
+            out += '"';
+        }
+        out += ch;
+    }
+    out += '"';
+    return out;
+}
+
+// One csv document out of the exports, written as it is mapped. Their columns differ (number of power sources, groups,
+// ext attributes...), the titles are merged in the order they are met and missing fields are left empty.
+static void concatenated(std::ostream& out, const std::vector<DcExport>& list)
+{
+    std::vector<std::string>      titles;
+    std::map<std::string, size_t> columns;
+    std::vector<std::string>      record;
+
+    // titles lines only, the records are read once they are written
+    for (const auto& item : list) {
+        size_t pos = 0;
+        if (!csvRecord(item.csv, pos, record)) {
+            continue;
+        }
+        for (auto& title : record) {
+            if (columns.emplace(title, titles.size()).second) {
+                titles.push_back(std::move(title));
+            }
+        }
+    }
+
+    auto line = [&](const std::vector<std::string>& fields) {
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (i) {
+                out << ',';
+            }
+            out << csvField(fields[i]);
+        }
+        out << '\n';
+    };
+
+    line(titles);
+    std::vector<std::string> fields;
+    for (const auto& item : list) {
+        size_t pos = 0;
+        if (!csvRecord(item.csv, pos, record)) {
+            continue;
+        }
+        std::vector<size_t> mapping;
+        for (const auto& title : record) {
+            mapping.push_back(columns[title]);
+        }
+        while (csvRecord(item.csv, pos, record)) {
+            fields.assign(titles.size(), std::string());
+            for (size_t col = 0; col < record.size() && col < mapping.size(); ++col) {
+                fields[mapping[col]] = std::move(record[col]);
+            }
+            line(fields);
+        }
+    }
+}
+
+// =========================================================================================================================================
+
+static void tarOctal(char* field, size_t size, uint64_t value)
+{
+    // size - 1 digits and a terminating nul
+    for (size_t i = size - 1; i-- > 0;) {
+        field[i] = char('0' + (value & 7));
+        value >>= 3;
+    }
+    field[size - 1] = '\0';
+}
+
+// Writes a regular file of a ustar archive, its data made of the parts
+static void tarFile(std::ostream& out, const std::string& name, std::initializer_list<std::string_view> parts, time_t mtime)
+{
+    size_t size = 0;
+    for (const auto& part : parts) {
+        size += part.size();
+    }
+
+    char header[512] = {};
+    name.copy(header, 99);
+    tarOctal(header + 100, 8, 0644);
+    tarOctal(header + 108, 8, 0);
+    tarOctal(header + 116, 8, 0);
+    tarOctal(header + 124, 12, size);
+    tarOctal(header + 136, 12, uint64_t(mtime));
+    std::fill(header + 148, header + 156, ' ');
+    header[156] = '0';
+    std::string("ustar").copy(header + 257, 5);
+    header[263] = '0';
+    header[264] = '0';
+
+    unsigned checksum = 0;
+    for (char ch : header) {
+        checksum += static_cast<unsigned char>(ch);
+    }
+    tarOctal(header + 148, 7, checksum);
+
+    static const char padding[512] = {};
+    out.write(header, sizeof(header));
+    for (const auto& part : parts) {
+        out.write(part.data(), std::streamsize(part.size()));
+    }
+    out.write(padding, std::streamsize((512 - size % 512) % 512));
+}
+
+// =========================================================================================================================================
+
 unsigned Export::run()
 {
-    rest::User user(m_request);
+    static auto&     stats = metrics::endpoint("asset/export");
+    metrics::Request measure(stats, m_reply);
+    // datacenter lookup and name, export
+    measure.budget(3);
+
+    metrics::Scope permissions(metrics::Phase::Permissions);
+    rest::User     user(m_request);
     if (auto ret = checkPermissions(user.profile(), m_permissions); !ret) {
         throw rest::Error(ret.error());
     }
+    permissions.stop();
 
-    auto                            dc = m_request.queryArg<std::string>("dc");
-    std::optional<db::AssetElement> dcAsset = std::nullopt;
-    if (dc) {
-        auto asset = db::selectAssetElementByName(*dc);
-        if (!asset || asset->typeId != persist::type_to_typeid("datacenter")) {
-            throw rest::errors::RequestParamBad("dc", "not a datacenter"_tr, "existing asset which is a datacenter"_tr);
-        }
-        dcAsset = *asset;
+    // several datacenters: dc=<name>,<name>... or dc=* for all of them
+    auto dc      = m_request.queryArg<std::string>("dc");
+    bool several = dc && (*dc == "*" || dc->find(',') != std::string::npos);
+
+    auto format = m_request.queryArg<std::string>("format");
+    if (format && *format != "tar" && *format != "csv") {
+        throw rest::errors::RequestParamBad("format", *format, "tar/csv");
     }
+    bool archive = !format || *format == "tar";
+
+    // one ticket for the whole export, its workers are bounded on their own
+    Admission::Ticket ticket(Admission::Class::Export);
+    if (!ticket.admitted()) {
+        m_reply.setHeader("Retry-After:", std::to_string(ticket.retryAfter()));
+        return HTTP_SERVICE_UNAVAILABLE;
+    }
+
+    metrics::Scope       dbScope(metrics::Phase::Db);
+    DbPool::Lease        lease(DbPool::instance().readTarget(user.login()));
+    fty::db::Connection& conn = lease.connection();
 
     auto time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
 
@@ -32,24 +313,118 @@ unsigned Export::run()
     ss << std::put_time(std::localtime(&time), "%FT%TZ");
     std::string strTime = std::regex_replace(ss.str(), std::regex(":"), "-");
 
+    if (several) {
+        measure.param("dc", *dc);
+
+        bool                     all = *dc == "*";
+        std::vector<std::string> names;
+        if (all) {
+            auto dcs = [&]() {
+                metrics::DbCall call;
+                return AssetManager::getItems("datacenter", {}, "name", OrderDir::Asc);
+            }();
+            if (!dcs) {
+                throw rest::errors::Internal(dcs.error());
+            }
+            metrics::rows(dcs->size());
+            for (const auto& it : *dcs) {
+                names.push_back(it.second);
+            }
+        } else {
+            names = split(*dc, ",");
+        }
+
+        std::vector<DcExport> list;
+        std::set<std::string> seen;
+        for (const auto& name : names) {
+            if (!seen.insert(name).second) {
+                continue;
+            }
+            metrics::DbCall call;
+            auto            asset = db::asset::selectAssetElementByName(conn, name);
+            if (!asset || asset->typeId != persist::type_to_typeid("datacenter")) {
+                throw rest::errors::RequestParamBad("dc", name, "existing asset which is a datacenter"_tr);
+            }
+            list.emplace_back().dc = *asset;
+        }
+
+        // datacenters listing, lookups, then names and exports in the workers
+        measure.budget((all ? 1 : 0) + 3 * list.size());
+
+        exportDatacenters(list, lease.target());
+        for (const auto& item : list) {
+            if (item.exception) {
+                std::rethrow_exception(item.exception);
+            }
+            if (!item.error.empty()) {
+                throw rest::errors::Internal(item.error);
+            }
+            measure.dbCall(item.namesTime, 0);
+            measure.dbCall(item.exportTime, 0);
+        }
+        dbScope.stop();
+
+        // written member by member, the archive is not built in memory besides the exports
+        if (archive) {
+            m_reply.setHeader(
+                tnt::httpheader::contentDisposition, "attachment; filename=\"asset_export_" + strTime + ".tar\"");
+            m_reply.setContentType("application/x-tar");
+
+            std::set<std::string> members;
+            for (auto& item : list) {
+                size_t      number = 0;
+                std::string member = memberName(item.name, strTime, number);
+                while (!members.insert(member).second) {
+                    member = memberName(item.name, strTime, ++number);
+                }
+                tarFile(m_reply.out(), member, {Bom, item.csv}, time);
+                std::string().swap(item.csv);
+            }
+            static const char end[1024] = {};
+            m_reply.out().write(end, sizeof(end));
+        } else {
+            m_reply.setHeader(
+                tnt::httpheader::contentDisposition, "attachment; filename=\"asset_export_" + strTime + ".csv\"");
+            m_reply.setContentType("text/csv;charset=UTF-8");
+            m_reply << Bom;
+            concatenated(m_reply.out(), list);
+        }
+
+        return HTTP_OK;
+    }
+
+    std::optional<db::AssetElement> dcAsset = std::nullopt;
+    if (dc) {
+        measure.param("dc", *dc);
+        metrics::DbCall call;
+        auto            asset = db::asset::selectAssetElementByName(conn, *dc);
+        if (!asset || asset->typeId != persist::type_to_typeid("datacenter")) {
+            throw rest::errors::RequestParamBad("dc", "not a datacenter"_tr, "existing asset which is a datacenter"_tr);
+        }
+        dcAsset = *asset;
+    }
+
     if (dcAsset != std::nullopt) {
-        auto dcENameRet = db::idToNameExtName(dcAsset->id);
+        metrics::DbCall call;
+        auto            dcENameRet = db::asset::idToNameExtName(conn, dcAsset->id);
         if (!dcENameRet) {
             throw rest::errors::ElementNotFound(dcAsset->id);
         }
-        // escape special characters
-        std::string dcEName = std::regex_replace(dcENameRet->second, std::regex("( |\t)"), "_");
         m_reply.setHeader(tnt::httpheader::contentDisposition,
-            "attachment; filename=\"asset_export_" + dcEName + "_" + strTime + ".csv\"");
+            "attachment; filename=\"asset_export_" + fileName(dcENameRet->second) + "_" + strTime + ".csv\"");
     } else {
         m_reply.setHeader(
             tnt::httpheader::contentDisposition, "attachment; filename=\"asset_export_" + strTime + ".csv\"");
     }
 
-    auto ret = AssetManager::exportCsv(dcAsset);
+    auto ret = [&]() {
+        metrics::DbCall call;
+        return AssetManager::exportCsv(dcAsset);
+    }();
+    dbScope.stop();
     if (ret) {
         m_reply.setContentType("text/csv;charset=UTF-8");
-        m_reply << "\xef\xbb\xbf";
+        m_reply << Bom;
         m_reply << *ret;
     } else {
         throw rest::errors::Internal(ret.error());
@@ -1,4 +1,8 @@
 #include "import.h"
+#include "admission.h"
+#include "asset-events.h"
+#include "db-pool.h"
+#include "metrics.h"
 #include <asset/asset-manager.h>
 #include <fty/rest/audit-log.h>
 #include <fty/rest/component.h>
@@ -16,10 +20,24 @@ struct Result : public pack::Node
 
 unsigned RestImport::run()
 {
-    rest::User user(m_request);
+    static auto&     stats = metrics::endpoint("asset/import");
+    metrics::Request measure(stats, m_reply);
+
+    metrics::Scope permissions(metrics::Phase::Permissions);
+    rest::User     user(m_request);
     if (auto ret = checkPermissions(user.profile(), m_permissions); !ret) {
         throw rest::Error(ret.error());
     }
+    permissions.stop();
+
+    Admission::Ticket ticket(Admission::Class::Import);
+    if (!ticket.admitted()) {
+        m_reply.setHeader("Retry-After:", std::to_string(ticket.retryAfter()));
+        return HTTP_SERVICE_UNAVAILABLE;
+    }
+
+    // reads of this client go to the primary database until the replica has the change
+    DbPool::Writer writer(user.login());
 
     // HARDCODED limit: can't import things larger than 128K
     // this prevents DoS attacks against the box - can be raised if needed
@@ -32,10 +50,17 @@ unsigned RestImport::run()
     }
 
     if (auto part = m_request.multipart("assets")) {
-        auto res = AssetManager::importCsv(*part, user.login());
+        metrics::Scope dbScope(metrics::Phase::Db);
+        auto           res = [&]() {
+            metrics::DbCall call;
+            return AssetManager::importCsv(*part, user.login());
+        }();
+        dbScope.stop();
         if (!res) {
             throw rest::errors::Internal(res.error());
         }
+        events::publish({events::Type::Reset});
+
         Result result;
         for (const auto& [row, el] : *res) {
             if (el) {
@@ -47,6 +72,8 @@ unsigned RestImport::run()
                 result.errors.append(err);
             }
         }
+
+        metrics::Scope serialization(metrics::Phase::Serialization);
         m_reply << *pack::json::serialize(result);
         return HTTP_OK;
     } else {
@@ -1,4 +1,11 @@
 #include "list-in.h"
+#include "admission.h"
+#include "batch-read.h"
+#include "binary-writer.h"
+#include "containment-tree.h"
+#include "db-pool.h"
+#include "metrics.h"
+#include "response-cache.h"
 #include <asset/asset-db2.h>
 #include <asset/asset-helpers.h>
 #include <asset/json.h>
@@ -7,6 +14,11 @@
 #include <fty_common_asset_types.h>
 #include <fty_common_db_connection.h>
 #include <pack/node.h>
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
 
 
 namespace fty::asset {
@@ -80,21 +92,186 @@ using AssetDetails = pack::ObjectList<AssetDetail>;
 
 // =========================================================================================================================================
 
+static void write(BinaryWriter& out, const Asset& asset, bool defaults)
+{
+    out.object(defaults, binaryField("id", asset.id), binaryField("name", asset.name), binaryField("type", asset.type),
+        binaryField("sub_type", asset.subType));
+}
+
+static void write(BinaryWriter& out, const AssetDetail::Power& power, bool defaults)
+{
+    out.object(defaults, binaryField("src_name", power.srcName), binaryField("src_id", power.srcId),
+        binaryField("src_socket", power.srcSocket), binaryField("dest_socket", power.destSocket));
+}
+
+static void write(BinaryWriter& out, const AssetDetail::Outlet& outlet, bool defaults)
+{
+    out.object(defaults, binaryField("name", outlet.name), binaryField("value", outlet.value),
+        binaryField("read_only", outlet.readOnly));
+}
+
+static void write(BinaryWriter& out, const AssetDetail& asset, bool defaults)
+{
+    // clang-format off
+    out.object(defaults,
+        binaryField("id",                   asset.id),
+        binaryField("power_devices_in_uri", asset.pdsInUri),
+        binaryField("name",                 asset.name),
+        binaryField("status",               asset.status),
+        binaryField("priority",             asset.priority),
+        binaryField("type",                 asset.type),
+        binaryField("location_uri",         asset.locationUri),
+        binaryField("location_id",          asset.locationId),
+        binaryField("location",             asset.location),
+        binaryField("location_type",        asset.locationType),
+        binaryField("sub_type",             asset.subType),
+        binaryField("powers",               asset.powers),
+        binaryField("ext",                  asset.ext),
+        binaryField("ips",                  asset.ips),
+        binaryField("outlets",              asset.outlets));
+    // clang-format on
+}
+
+// With a projection the base members are always written, the sections only when asked for, even if empty. Without
+// defaults pack would leave out every member without value, an empty sub_type included.
+
+static void write(BinaryWriter& out, const AssetDetail& asset, const ListIn::Sections& sections)
+{
+    size_t sectionCount = (sections.location ? 4 : 0) + size_t(sections.powers) + size_t(sections.ext) + size_t(sections.ips) +
+                          size_t(sections.outlets);
+    out.map(7 + sectionCount);
+
+    auto field = [&](const char* key, const auto& value) {
+        out.string(key);
+        write(out, value, true);
+    };
+
+    field("id", asset.id);
+    field("power_devices_in_uri", asset.pdsInUri);
+    field("name", asset.name);
+    field("status", asset.status);
+    field("priority", asset.priority);
+    field("type", asset.type);
+    if (sections.location) {
+        field("location_uri", asset.locationUri);
+        field("location_id", asset.locationId);
+        field("location", asset.location);
+        field("location_type", asset.locationType);
+    }
+    field("sub_type", asset.subType);
+    if (sections.powers) {
+        field("powers", asset.powers);
+    }
+    if (sections.ext) {
+        field("ext", asset.ext);
+    }
+    if (sections.ips) {
+        field("ips", asset.ips);
+    }
+    if (sections.outlets) {
+        field("outlets", asset.outlets);
+    }
+}
+
+static void write(BinaryWriter& out, const AssetDetails& list, const ListIn::Sections& sections)
+{
+    out.array(size_t(list.size()));
+    for (const auto& asset : list) {
+        write(out, asset, sections);
+    }
+}
+
+static void jsonString(std::string& out, std::string_view value)
+{
+    out += '"';
+    for (char ch : value) {
+        if (ch == '"' || ch == '\\') {
+            out += '\\';
+            out += ch;
+        } else if (static_cast<unsigned char>(ch) < 0x20) {
+            out += fmt::format("\\u{:04x}", int(ch));
+        } else {
+            out += ch;
+        }
+    }
+    out += '"';
+}
+
+static std::string json(const AssetDetails& list, const ListIn::Sections& sections)
+{
+    std::string out = "[";
+    for (const auto& asset : list) {
+        if (out.size() > 1) {
+            out += ",";
+        }
+
+        char separator = '{';
+        auto key       = [&](const char* name) {
+            out += separator;
+            separator = ',';
+            jsonString(out, name);
+            out += ":";
+        };
+        auto field = [&](const char* name, const pack::String& value) {
+            key(name);
+            jsonString(out, value.value());
+        };
+        auto section = [&](const char* name, const auto& value) {
+            key(name);
+            out += *pack::json::serialize(value, pack::Option::WithDefaults);
+        };
+
+        field("id", asset.id);
+        field("power_devices_in_uri", asset.pdsInUri);
+        field("name", asset.name);
+        field("status", asset.status);
+        field("priority", asset.priority);
+        field("type", asset.type);
+        if (sections.location) {
+            field("location_uri", asset.locationUri);
+            field("location_id", asset.locationId);
+            field("location", asset.location);
+            field("location_type", asset.locationType);
+        }
+        field("sub_type", asset.subType);
+        if (sections.powers) {
+            section("powers", asset.powers);
+        }
+        if (sections.ext) {
+            section("ext", asset.ext);
+        }
+        if (sections.ips) {
+            section("ips", asset.ips);
+        }
+        if (sections.outlets) {
+            section("outlets", asset.outlets);
+        }
+        out += "}";
+    }
+    out += "]";
+    return out;
+}
+
+// =========================================================================================================================================
+
 static Assets assetsInContainer(
     fty::db::Connection&             conn,
     uint32_t                         container,
     const db::asset::select::Filter& filter,
     const db::asset::select::Order&  order,
-    const std::vector<std::string>&  capabilities)
+    const std::vector<std::string>&  capabilities,
+    std::vector<uint32_t>&           ids)
 {
     Assets result;
 
     auto func = [&](const fty::db::Row& row) {
+        metrics::rows(1);
         uint32_t assetId = row.get<uint32_t>("id");
 
         // search capabilities if present in filter
         auto keyTag = [&](const std::string& value) {
-            std::string capability = fmt::format("capability.{}", value);
+            std::string     capability = fmt::format("capability.{}", value);
+            metrics::DbCall call;
             if (auto ret = db::asset::countKeytag(conn, capability, "yes", assetId)) {
                 return *ret > 0;
             } else {
@@ -112,9 +289,11 @@ static Assets assetsInContainer(
             asset.name    = row.get("extName");
             asset.type    = row.get("typeName");
             asset.subType = persist::subtypeid_to_subtype(row.get<uint16_t>("subTypeId"));
+            ids.push_back(assetId);
         }
     };
 
+    metrics::DbCall call;
     if (container) {
         auto list = db::asset::select::itemsByContainer(conn, container, func, filter, order);
         if (!list) {
@@ -129,146 +308,274 @@ static Assets assetsInContainer(
     return result;
 }
 
+// Same list as above, located in the in-memory tree: only the external names are read from the database.
+// Nothing if the container is not in the tree.
+static std::optional<Assets> assetsInTree(
+    fty::db::Connection& conn, uint32_t container, const ContainmentTree::Filter& filter, bool desc, std::vector<uint32_t>& ids)
+{
+    auto found = ContainmentTree::instance().descendants(container, filter);
+    if (!found) {
+        return std::nullopt;
+    }
+
+    auto& nodes = *found;
+    if (desc) {
+        std::reverse(nodes.begin(), nodes.end());
+    }
+    metrics::rows(nodes.size());
+
+    ids.reserve(nodes.size());
+    for (const auto& node : nodes) {
+        ids.push_back(node.id);
+    }
+    auto names = batch::extNames(conn, ids);
+
+    Assets result;
+    for (const auto& node : nodes) {
+        auto& asset = result.append();
+
+        auto name     = names.find(node.id);
+        asset.id      = node.name;
+        asset.name    = name != names.end() ? name->second : node.name;
+        asset.type    = persist::typeid_to_type(node.typeId);
+        asset.subType = persist::subtypeid_to_subtype(node.subTypeId);
+    }
+    return result;
+}
+
 // =========================================================================================================================================
 
-struct Outlet
+// Ext attributes are sorted into outlets, ips and generic ext in one pass, without copying keys or values.
+
+enum class AttrClass
 {
-    db::asset::ExtAttrValue label;
-    db::asset::ExtAttrValue type;
-    db::asset::ExtAttrValue group;
-    db::asset::ExtAttrValue name;
-    db::asset::ExtAttrValue switchable;
+    Ext,          // generic ext attribute
+    Skip,         // not shown
+    Ip,           // ip.<n>
+    MasterOutlet, // outlet.[id|label|switchable] of ups/epdu, outlet "0"
+    Outlet        // outlet.<id>.<property>
 };
 
-// parse ext. attribute as "outlet.<id>.<property-name>
-// with exceptions for master outlet (ups/epdu)
-// returns <outlet id, property name> (empty if inconsistent)
+struct AttrPrefix
+{
+    std::string_view key;
+    bool             exact;
+    AttrClass        cls;
+};
 
-static std::pair<std::string, std::string> getOutletIdAndProperty(const std::string& extAttributeName)
+// clang-format off
+static constexpr std::array<AttrPrefix, 7> AttrPrefixes = {{
+    {"name",              true,  AttrClass::Skip},
+    {"location_type",     true,  AttrClass::Skip},
+    {"ip.",               false, AttrClass::Ip},
+    {"outlet.id",         true,  AttrClass::MasterOutlet},
+    {"outlet.label",      true,  AttrClass::MasterOutlet},
+    {"outlet.switchable", true,  AttrClass::MasterOutlet},
+    {"outlet.",           false, AttrClass::Outlet},
+}};
+// clang-format on
+
+static AttrClass classify(std::string_view key)
 {
-    // exception: handle outlet.["id"|"switchable"|"label"] (ups/epdu)
-    // ZZZ assume master outletId is "0"
-    if (extAttributeName == "outlet.id") {
-        return {"0", "id"};
-    }
-    if (extAttributeName == "outlet.switchable") {
-        return {"0", "switchable"};
-    }
-    if (extAttributeName == "outlet.label") {
-        return {"0", "label"};
+    for (const auto& it : AttrPrefixes) {
+        if (it.exact ? key == it.key : key.substr(0, it.key.size()) == it.key) {
+            return it.cls;
+        }
     }
-    //
+    return AttrClass::Ext;
+}
 
-    if (extAttributeName.find("outlet.") != 0) {
-        return {}; // empty
-    }
-    auto dot = extAttributeName.find_first_of(".");
-    if (dot == std::string::npos) {
-        return {}; // empty
+struct Outlet
+{
+    // id is a view on the key of the attribute
+    std::string_view               id;
+    const batch::Attribute* label      = nullptr;
+    const batch::Attribute* type       = nullptr;
+    const batch::Attribute* group      = nullptr;
+    const batch::Attribute* name       = nullptr;
+    const batch::Attribute* switchable = nullptr;
+
+    void set(std::string_view property, const batch::Attribute& value)
+    {
+        if (property == "label") {
+            label = &value;
+        } else if (property == "group") {
+            group = &value;
+        } else if (property == "type") {
+            type = &value;
+        } else if (property == "name") {
+            name = &value;
+        } else if (property == "switchable") {
+            switchable = &value;
+        }
     }
-    std::string aux = extAttributeName.substr(dot + 1);
-    dot = aux.find_first_of(".");
-    if (dot == std::string::npos) {
-        return {}; // empty
+};
+
+// Splits "outlet.<id>.<property>", id must be a number > 0.
+static bool outletIdAndProperty(std::string_view key, std::string_view& id, std::string_view& property)
+{
+    key.remove_prefix(std::string_view("outlet.").size());
+
+    auto dot = key.find('.');
+    if (dot == 0 || dot == std::string_view::npos || dot + 1 == key.size()) {
+        return false;
     }
 
-    auto outletId = aux.substr(0, dot);
-    auto propertyName = aux.substr(dot + 1);
+    id       = key.substr(0, dot);
+    property = key.substr(dot + 1);
 
-    try {
-        auto i = std::stoi(outletId);
-        if (i <= 0) {
-            return {}; // inconsistent (>0 required)
+    bool positive = false;
+    for (char ch : id) {
+        if (ch < '0' || ch > '9') {
+            return false;
         }
+        positive |= ch != '0';
     }
-    catch (...) {
-        return {}; // not an int
-    }
-
-    return {outletId, propertyName};
+    return positive;
 }
 
-static std::map<std::string, Outlet> collectOutlets(const db::asset::Attributes& ext)
+// Outlets in the order of their ids (as strings). With attributes sorted by key, all the attributes of an outlet are
+// next to each other and outlets already come in that order; the master outlet "0" is kept apart and goes first.
+struct Outlets
 {
-    std::map<std::string, Outlet> outlets;
+    std::optional<Outlet> master;
+    std::vector<Outlet>   numbered;
 
-    for (const auto& [key, value] : ext) {
-        // key match "outlet.<id>.<property-name>"?
-        auto pair = getOutletIdAndProperty(key);
-        auto outletId = pair.first;
-        auto propertyName = pair.second;
-        if (outletId.empty() || propertyName.empty()) {
-            continue; // don't match
+    Outlet& get(std::string_view id)
+    {
+        if (numbered.empty() || numbered.back().id != id) {
+            numbered.emplace_back().id = id;
         }
+        return numbered.back();
+    }
 
-        if (outlets.find(outletId) == outlets.end()) {
-            outlets[outletId] = Outlet{}; // create
-            outlets[outletId].label.value = outletId; // default required
-            outlets[outletId].label.readOnly = true;
+    // only needed if the attributes were not sorted: orders the outlets and merges the parts of the same one
+    void finish()
+    {
+        auto byId = [](const Outlet& l, const Outlet& r) {
+            return l.id < r.id;
+        };
+        if (std::is_sorted(numbered.begin(), numbered.end(), byId)) {
+            return;
         }
 
-        if (propertyName == "label") {
-            outlets[outletId].label = value;
-        }
-        else if (propertyName == "group") {
-            outlets[outletId].group = value;
-        }
-        else if (propertyName == "type") {
-            outlets[outletId].type = value;
-        }
-        else if (propertyName == "name") {
-            outlets[outletId].name = value;
-        }
-        else if (propertyName == "switchable") {
-            outlets[outletId].switchable = value;
+        std::stable_sort(numbered.begin(), numbered.end(), byId);
+
+        std::vector<Outlet> merged;
+        for (const auto& outlet : numbered) {
+            if (merged.empty() || merged.back().id != outlet.id) {
+                merged.push_back(outlet);
+                continue;
+            }
+            auto& dst = merged.back();
+            for (auto member : {&Outlet::label, &Outlet::type, &Outlet::group, &Outlet::name, &Outlet::switchable}) {
+                if (outlet.*member) {
+                    dst.*member = outlet.*member;
+                }
+            }
         }
+        numbered = std::move(merged);
     }
 
-    return outlets;
+    bool empty() const
+    {
+        return !master && numbered.empty();
+    }
+};
+
+static void appendOutletProperty(AssetDetail::OutletList& list, const char* name, const batch::Attribute* value)
+{
+    if (value && !value->value.empty()) {
+        auto& out    = list.append();
+        out.name     = name;
+        out.value    = value->value;
+        out.readOnly = convert<std::string>(value->readOnly);
+    }
 }
 
-static void fetchFullInfo(fty::db::Connection& conn, AssetDetail& asset, const std::string& id)
+static void appendOutlet(AssetDetail& asset, const Outlet& outlet)
 {
-    auto info = db::asset::select::itemExt(conn, id);
-    if (!info) {
-        throw rest::errors::Internal(info.error());
+    std::string              id(outlet.id);
+    AssetDetail::OutletList& list = asset.outlets.append(id);
+
+    // ensure outlet label is defined (required)
+    {
+        auto& out = list.append();
+        out.name  = "label";
+        if (outlet.label && !outlet.label->value.empty()) {
+            out.value    = outlet.label->value;
+            out.readOnly = convert<std::string>(outlet.label->readOnly);
+        } else {
+            out.value    = id;
+            out.readOnly = "true";
+        }
     }
 
-    db::asset::Attributes ext;
-    if (auto ret = db::asset::select::extAttributes(conn, info->id); !ret) {
-        throw rest::errors::Internal(ret.error());
-    } else {
-        ext = *ret;
+    appendOutletProperty(list, "group", outlet.group);
+    appendOutletProperty(list, "type", outlet.type);
+    appendOutletProperty(list, "name", outlet.name);
+    appendOutletProperty(list, "switchable", outlet.switchable);
+}
+
+// What the details of the listed assets are made of, read for all of them at once
+struct DetailsData
+{
+    std::unordered_map<uint32_t, batch::Element>           elements;
+    std::unordered_map<uint32_t, batch::Attributes>        attributes;
+    std::unordered_map<uint32_t, std::vector<batch::Link>> links;
+};
+
+// Up to 3 statements per batch::Size assets
+static DetailsData fetchDetails(fty::db::Connection& conn, const std::vector<uint32_t>& ids, const ListIn::Sections& sections)
+{
+    DetailsData data;
+    data.elements = batch::elements(conn, ids);
+
+    // type of a group is its subtype, an ext attribute
+    bool groups = std::any_of(data.elements.begin(), data.elements.end(), [](const auto& it) {
+        return it.second.typeId == persist::type_to_typeid("group");
+    });
+    if (sections.ext || sections.ips || sections.outlets || groups) {
+        data.attributes = batch::attributes(conn, ids);
+    }
+    if (sections.powers) {
+        data.links = batch::powerLinks(conn, ids);
     }
+    return data;
+}
 
-    auto outlets = collectOutlets(ext);
+static void fillDetail(AssetDetail& asset, const batch::Element& info, const DetailsData& data, const ListIn::Sections& sections)
+{
+    static const batch::Attributes        noAttributes;
+    static const std::vector<batch::Link> noLinks;
 
-    asset.id       = info->name;
-    asset.name     = info->extName;
-    asset.status   = info->status;
-    asset.priority = fmt::format("P{}", info->priority);
-    asset.type     = info->typeName;
+    auto        found = data.attributes.find(info.id);
+    const auto& ext   = found != data.attributes.end() ? found->second : noAttributes;
 
-    if (info->parentId > 0) {
-        auto location = db::asset::idToNameExtName(conn, info->parentId);
-        if (!location) {
-            throw rest::errors::Internal(location.error());
-        }
-        asset.locationUri  = fmt::format("/api/v1/asset/{}", location->name);
-        asset.locationId   = location->name;
-        asset.location     = location->extName;
-        asset.locationType = persist::typeid_to_type(info->parentTypeId);
+    // type of a group is its subtype, not shown as ext attribute
+    bool isGroup = info.typeId == persist::type_to_typeid("group");
+
+    asset.id       = info.name;
+    asset.name     = info.extName;
+    asset.status   = info.status;
+    asset.priority = fmt::format("P{}", info.priority);
+    asset.type     = persist::typeid_to_type(info.typeId);
+
+    if (sections.location && info.parentId > 0) {
+        asset.locationUri  = fmt::format("/api/v1/asset/{}", info.parentName);
+        asset.locationId   = info.parentName;
+        asset.location     = info.parentExtName;
+        asset.locationType = persist::typeid_to_type(info.parentTypeId);
     }
 
     {
         std::string subTypeName;
-        if (info->typeName == "group") {
-            if (ext.count("type")) {
-                subTypeName = ext["type"].value;
-                ext.erase("type");
+        if (isGroup) {
+            if (auto it = ext.find("type"); it != ext.end()) {
+                subTypeName = it->second.value;
             }
         } else {
-            subTypeName =  persist::subtypeid_to_subtype(info->subtypeId);
+            subTypeName = persist::subtypeid_to_subtype(info.subTypeId);
         }
         if (subTypeName == "N_A") {
             subTypeName = "";
@@ -276,114 +583,124 @@ static void fetchFullInfo(fty::db::Connection& conn, AssetDetail& asset, const s
         asset.subType = subTypeName;
     }
 
-    if (auto links = db::asset::select::deviceLinksTo(conn, info->id)) {
-        for (const auto& link : *links) {
-            if (auto extname = db::asset::nameToExtName(conn, link.srcName)) {
-                auto& power      = asset.powers.append();
-                power.srcId      = link.srcName;
-                power.srcName    = *extname;
-                power.srcSocket  = link.srcSocket;
-                power.destSocket = link.destSocket;
-            } else {
-                throw rest::errors::Internal(extname.error());
-            }
+    if (sections.powers) {
+        auto links = data.links.find(info.id);
+        for (const auto& link : links != data.links.end() ? links->second : noLinks) {
+            auto& power      = asset.powers.append();
+            power.srcId      = link.srcName;
+            power.srcName    = link.srcExtName;
+            power.srcSocket  = link.srcSocket;
+            power.destSocket = link.destSocket;
         }
-    } else {
-        throw rest::errors::Internal(links.error());
     }
 
-    {
-        auto it = ext.find("logical_asset");
-        if (it != ext.end()) {
-            auto extname = db::asset::nameToExtName(conn, it->second.value);
-            if (!extname) {
-                throw rest::errors::Internal(extname.error());
-            }
-            ext["logical_asset"] = {*extname, it->second.readOnly};
-        }
-    }
-
-    if (!info->assetTag.empty()) {
+    if (sections.ext && !info.assetTag.empty()) {
         auto& tag = asset.ext.append();
-        tag.append("asset_tag", info->assetTag);
+        tag.append("asset_tag", info.assetTag);
         tag.append("read_only", "false");
     }
 
+    Outlets outlets;
     for (const auto& [key, value] : ext) {
-        if (key == "name" || key == "location_type") {
+        AttrClass cls = classify(key);
+
+        if (cls == AttrClass::Skip || (isGroup && key == "type")) {
             continue;
         }
 
-        if (key.find("ip.") == 0) {
-            asset.ips.append(value.value);
+        if (cls == AttrClass::Ip) {
+            if (sections.ips) {
+                asset.ips.append(value.value);
+            }
             continue;
         }
 
+        if (sections.outlets && cls == AttrClass::MasterOutlet) {
+            if (!outlets.master) {
+                outlets.master.emplace().id = "0";
+            }
+            outlets.master->set(std::string_view(key).substr(std::string_view("outlet.").size()), value);
+        } else if (sections.outlets && cls == AttrClass::Outlet) {
+            std::string_view outletId, property;
+            if (outletIdAndProperty(key, outletId, property)) {
+                outlets.get(outletId).set(property, value);
+            }
+        }
+
+        if (!sections.ext) {
+            continue;
+        }
+
+        // logical asset is shown by its external name
         auto& attr = asset.ext.append();
-        attr.append(key, value.value);
+        if (key == "logical_asset" && !value.extName.empty()) {
+            attr.append(key, value.extName);
+        } else {
+            attr.append(key, value.value);
+        }
         attr.append("read_only", convert<std::string>(value.readOnly));
     }
 
-    // exception: ensure that sts device have at least one outlet (main)
-    if ((outlets.size() == 0) && (asset.subType == "sts")) {
-        outlets["0"] = Outlet{};
-        outlets["0"].name.value = "0";
-        outlets["0"].name.readOnly = true;
-        outlets["0"].label.value = "Main";
-        outlets["0"].label.readOnly = true;
+    if (!sections.outlets) {
+        return;
     }
+    outlets.finish();
 
-    for (const auto& [oNumber, outlet] : outlets) {
-        // exception: ignore outlet "0" for epdu (not a physical outlet)
-        if ((oNumber == "0") && (asset.subType == "epdu")) {
-            continue;
-        }
+    // exception: ensure that sts device have at least one outlet (main)
+    if (outlets.empty() && asset.subType == "sts") {
+        AssetDetail::OutletList& list = asset.outlets.append("0");
 
-        AssetDetail::OutletList& list = asset.outlets.append(oNumber);
+        auto& label    = list.append();
+        label.name     = "label";
+        label.value    = "Main";
+        label.readOnly = "true";
 
-        // ensure outlet label is defined (required)
-        {
-            auto& out = list.append();
-            out.name  = "label";
-            if (!outlet.label.value.empty()) {
-                out.value = outlet.label.value;
-                out.readOnly = convert<std::string>(outlet.label.readOnly);
-            }
-            else {
-                out.value = oNumber;
-                out.readOnly = "true";
-            }
-        }
+        auto& name    = list.append();
+        name.name     = "name";
+        name.value    = "0";
+        name.readOnly = "true";
+        return;
+    }
 
-        if (!outlet.group.value.empty()) {
-            auto& out    = list.append();
-            out.name     = "group";
-            out.value    = outlet.group.value;
-            out.readOnly = convert<std::string>(outlet.group.readOnly);
-        }
-        if (!outlet.type.value.empty()) {
-            auto& out    = list.append();
-            out.name     = "type";
-            out.value    = outlet.type.value;
-            out.readOnly = convert<std::string>(outlet.type.readOnly);
-        }
-        if (!outlet.name.value.empty()) {
-            auto& out    = list.append();
-            out.name     = "name";
-            out.value    = outlet.name.value;
-            out.readOnly = convert<std::string>(outlet.name.readOnly);
-        }
-        if (!outlet.switchable.value.empty()) {
-            auto& out    = list.append();
-            out.name     = "switchable";
-            out.value    = outlet.switchable.value;
-            out.readOnly = convert<std::string>(outlet.switchable.readOnly);
-        }
+    // exception: ignore outlet "0" for epdu (not a physical outlet)
+    if (outlets.master && asset.subType != "epdu") {
+        appendOutlet(asset, *outlets.master);
+    }
+    for (const auto& outlet : outlets.numbered) {
+        appendOutlet(asset, outlet);
     }
 }
 
 // =========================================================================================================================================
 
+ListIn::Sections ListIn::fields() const
+{
+    Sections ret;
+
+    auto fields = m_request.queryArg<std::string>("fields");
+    if (!fields || fields->empty()) {
+        return ret;
+    }
+
+    ret = {false, false, false, false, false, false};
+    for (const auto& it : split(*fields, ",")) {
+        if (it == "location") {
+            ret.location = true;
+        } else if (it == "powers") {
+            ret.powers = true;
+        } else if (it == "ext") {
+            ret.ext = true;
+        } else if (it == "ips") {
+            ret.ips = true;
+        } else if (it == "outlets") {
+            ret.outlets = true;
+        } else {
+            throw rest::errors::RequestParamBad("fields", *fields, "list of location, powers, ext, ips, outlets"_tr);
+        }
+    }
+    return ret;
+}
+
 uint32_t ListIn::containerId() const
 {
     auto id = m_request.queryArg<std::string>("in");
@@ -399,6 +716,20 @@ uint32_t ListIn::containerId() const
     }
 }
 
+std::optional<uint32_t> ListIn::depth() const
+{
+    auto levels = m_request.queryArg<std::string>("depth");
+
+    if (!levels || levels->empty()) {
+        return std::nullopt;
+    }
+
+    if (levels->size() > 4 || !std::all_of(levels->begin(), levels->end(), ::isdigit) || *levels == "0") {
+        throw rest::errors::RequestParamBad("depth", *levels, "number of levels from 1 to 9999"_tr);
+    }
+    return uint32_t(std::stoul(*levels));
+}
+
 std::vector<uint16_t> ListIn::types() const
 {
     std::vector<uint16_t> ret;
@@ -454,55 +785,194 @@ std::vector<std::string> ListIn::capabilities() const
 
 unsigned ListIn::run()
 {
-    rest::User user(m_request);
+    static auto&     stats = metrics::endpoint("asset/list-in");
+    metrics::Request measure(stats, m_reply);
+
+    metrics::Scope permissions(metrics::Phase::Permissions);
+    rest::User     user(m_request);
     if (auto ret = checkPermissions(user.profile(), m_permissions); !ret) {
         throw rest::Error(ret.error());
     }
+    permissions.stop();
 
     if (m_request.type() != rest::Request::Type::Get) {
         throw rest::errors::MethodNotAllowed(m_request.typeStr());
     }
 
-    auto details = m_request.queryArg<bool>("details");
-
-    db::Connection conn;
-
-    db::asset::select::Filter flt;
-    flt.types    = types();
-    flt.subtypes = subTypes();
-    if (auto without = m_request.queryArg<std::string>("without")) {
-        flt.without = *without;
+    auto details  = m_request.queryArg<bool>("details");
+    auto sections = fields();
+    auto binary   = BinaryWriter::negotiate(m_request.header("Accept"));
+    if (auto in = m_request.queryArg<std::string>("in")) {
+        measure.param("in", *in);
     }
-    if (auto status = m_request.queryArg<std::string>("status")) {
-        flt.status = *status;
+    if (auto type = m_request.queryArg<std::string>("type")) {
+        measure.param("type", *type);
     }
-
-    db::asset::select::Order order;
-    order.field = "name";
-    order.dir = db::asset::select::Order::Dir::Asc;
-
-    if (auto by = m_request.queryArg<std::string>("orderBy")) {
-        order.field = *by;
+    if (auto levels = m_request.queryArg<std::string>("depth")) {
+        measure.param("depth", *levels);
     }
-    if (auto dir = m_request.queryArg<std::string>("order")) {
-        order.dir = *dir == "ASC" ? db::asset::select::Order::Dir::Asc : db::asset::select::Order::Dir::Desc;
+    measure.param("details", details && *details ? "true" : "false");
+    if (auto fieldsArg = m_request.queryArg<std::string>("fields")) {
+        measure.param("fields", *fieldsArg);
     }
 
+    // the containment tree follows the primary database, listings by depth need it
+    auto target = DbPool::instance().readTarget(user.login());
+    if (m_request.queryArg<std::string>("depth")) {
+        target = DbPool::Target::Primary;
+    }
 
-    auto assets = assetsInContainer(conn, containerId(), flt, order, capabilities());
+    // repeated listings are served from the cache, identical ones asked at the same time are computed once
+    auto arg = [&](const std::string& name) {
+        auto value = m_request.queryArg<std::string>(name);
+        return value ? *value : std::string();
+    };
+    // the order of the items of a list does not change the reply, as for the subtypes of list
+    auto listArg = [&](const std::string& name) {
+        auto items = split(arg(name), ",");
+        std::sort(items.begin(), items.end());
+        return implode(items, ",");
+    };
+    auto key = fmt::format("list-in|{}|{}|{}|{}|{}|{}|{}|{}|{}|{}|{}|{}|{}|{}", int(user.profile()), int(target),
+        binary ? int(*binary) : -1, details && *details, arg("in"), listArg("type"), listArg("sub_type"), arg("status"),
+        arg("without"), listArg("capability"), arg("orderBy"), arg("order"), listArg("fields"), arg("depth"));
+
+    auto compute = [&]() {
+        SingleFlight::Reply reply;
+        reply.status = HTTP_OK;
+
+        // detailed listings are heavy requests
+        std::optional<Admission::Ticket> ticket;
+        if (details && *details) {
+            ticket.emplace(Admission::Class::Listing);
+            if (!ticket->admitted()) {
+                reply.status = HTTP_SERVICE_UNAVAILABLE;
+                reply.headers.emplace_back("Retry-After:", std::to_string(ticket->retryAfter()));
+                return reply;
+            }
+        }
+
+        metrics::Scope       dbScope(metrics::Phase::Db);
+        DbPool::Lease        lease(target);
+        fty::db::Connection& conn = lease.connection();
 
-    if (details && *details) {
-        AssetDetails list;
-        for (auto const& asset : assets) {
-            auto& detail = list.append();
-            fetchFullInfo(conn, detail, asset.id);
+        db::asset::select::Filter flt;
+        flt.types    = types();
+        flt.subtypes = subTypes();
+        if (auto without = m_request.queryArg<std::string>("without")) {
+            flt.without = *without;
         }
-        m_reply << *pack::json::serialize(list, pack::Option::WithDefaults);
-    } else {
-        m_reply << *pack::json::serialize(assets);
+        if (auto status = m_request.queryArg<std::string>("status")) {
+            flt.status = *status;
+        }
+
+        db::asset::select::Order order;
+        order.field = "name";
+        order.dir = db::asset::select::Order::Dir::Asc;
+
+        if (auto by = m_request.queryArg<std::string>("orderBy")) {
+            order.field = *by;
+        }
+        if (auto dir = m_request.queryArg<std::string>("order")) {
+            order.dir = *dir == "ASC" ? db::asset::select::Order::Dir::Asc : db::asset::select::Order::Dir::Desc;
+        }
+
+
+        auto caps      = capabilities();
+        auto container = containerId();
+        auto levels    = depth();
+
+        // the tree answers containers listed by name, other filters and orders are left to the database. It is loaded
+        // from the primary database: replica reads do not mix it with details the replica may not have yet.
+        bool inTree = lease.target() == DbPool::Target::Primary && container && flt.without.empty() && caps.empty() &&
+                      order.field == "name";
+        if (levels && !inTree) {
+            throw rest::errors::RequestParamBad("depth", std::to_string(*levels), "depth with in, without capability and without"_tr);
+        }
+
+        std::optional<Assets> assets;
+        std::vector<uint32_t> ids;
+        if (inTree) {
+            ContainmentTree::Filter tree;
+            tree.types    = flt.types;
+            tree.subTypes = flt.subtypes;
+            tree.status   = flt.status;
+            tree.depth    = levels.value_or(0);
+
+            assets = assetsInTree(conn, container, tree, order.dir == db::asset::select::Order::Dir::Desc, ids);
+        }
+        // container not in the tree yet, the database knows better
+        bool treeLoaded = inTree;
+        if (!assets) {
+            inTree = false;
+            assets = assetsInContainer(conn, container, flt, order, caps, ids);
+        }
+
+        // listing (reload of the tree and names), details: a capability filter costs a query per asset
+        if (caps.empty()) {
+            size_t listing = (treeLoaded ? 1 : 0) + (inTree ? batch::statements(ids.size()) : 1);
+            size_t detail  = details && *details ? batch::statements(ids.size(), 3) : 0;
+            measure.budget(listing + detail);
+        }
+
+        if (details && *details) {
+            auto data = fetchDetails(conn, ids, sections);
+
+            AssetDetails list;
+            for (auto id : ids) {
+                // removed since listed
+                auto info = data.elements.find(id);
+                if (info != data.elements.end()) {
+                    fillDetail(list.append(), info->second, data, sections);
+                }
+            }
+            dbScope.stop();
+
+            // with a projection the sections not asked for are left out
+            metrics::Scope serialization(metrics::Phase::Serialization);
+            if (binary) {
+                BinaryWriter out(*binary);
+                if (sections.all) {
+                    write(out, list, true);
+                } else {
+                    write(out, list, sections);
+                }
+                reply.contentType = out.contentType();
+                reply.body        = out.data();
+            } else if (sections.all) {
+                reply.body = *pack::json::serialize(list, pack::Option::WithDefaults);
+            } else {
+                reply.body = json(list, sections);
+            }
+        } else {
+            dbScope.stop();
+
+            metrics::Scope serialization(metrics::Phase::Serialization);
+            if (binary) {
+                BinaryWriter out(*binary);
+                write(out, *assets, false);
+                reply.contentType = out.contentType();
+                reply.body        = out.data();
+            } else {
+                reply.body = *pack::json::serialize(*assets);
+            }
+        }
+
+        return reply;
+    };
+
+    auto reply = ResponseCache::instance().run(key, compute, target);
+    // the format follows the Accept header, caches in between must keep the replies apart
+    m_reply.setHeader("Vary:", "Accept");
+    for (const auto& [name, value] : reply->headers) {
+        m_reply.setHeader(name, value);
+    }
+    if (!reply->contentType.empty()) {
+        m_reply.setContentType(reply->contentType);
     }
+    m_reply << reply->body;
 
-    return HTTP_OK;
+    return reply->status;
 }
 
 // =========================================================================================================================================
@@ -21,6 +21,7 @@
 
 #pragma once
 #include <fty/rest/runner.h>
+#include <optional>
 
 namespace fty::asset {
 
@@ -32,8 +33,21 @@ public:
 public:
     unsigned run() override;
 
+    /// Sections of the asset details, selected by the `fields` parameter
+    struct Sections
+    {
+        bool all      = true;
+        bool location = true;
+        bool powers   = true;
+        bool ext      = true;
+        bool ips      = true;
+        bool outlets  = true;
+    };
+
 private:
+    Sections                 fields() const;
     uint32_t                 containerId() const;
+    std::optional<uint32_t>  depth() const;
     std::vector<uint16_t>    types() const;
     std::vector<uint16_t>    subTypes() const;
     std::vector<std::string> capabilities() const;
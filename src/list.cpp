@@ -1,9 +1,16 @@
 #include "list.h"
-#include <asset/asset-db.h>
+#include "batch-read.h"
+#include "binary-writer.h"
+#include "db-pool.h"
+#include "metrics.h"
+#include "response-cache.h"
+#include <algorithm>
 #include <asset/asset-manager.h>
+#include <fmt/format.h>
 #include <fty/rest/component.h>
 #include <fty/string-utils.h>
 #include <fty_common_asset_types.h>
+#include <fty_common_db_connection.h>
 #include <pack/pack.h>
 
 namespace fty::asset {
@@ -17,15 +24,25 @@ struct Info : public pack::Node
     META(Info, id, name);
 };
 
+static void write(BinaryWriter& out, const Info& info, bool defaults)
+{
+    out.object(defaults, binaryField("id", info.id), binaryField("name", info.name));
+}
+
 unsigned List::run()
 {
     static const std::set<std::string> possibleOrders = {
         "name", "model", "create_ts", "firmware", "max_power", "serial_no", "update_ts", "asset_order"};
 
-    rest::User user(m_request);
+    static auto&     stats = metrics::endpoint("asset/list");
+    metrics::Request measure(stats, m_reply);
+
+    metrics::Scope permissions(metrics::Phase::Permissions);
+    rest::User     user(m_request);
     if (auto ret = checkPermissions(user.profile(), m_permissions); !ret) {
         throw rest::Error(ret.error());
     }
+    permissions.stop();
 
     if (m_request.type() != rest::Request::Type::Get) {
         throw rest::errors::MethodNotAllowed(m_request.typeStr());
@@ -74,29 +91,71 @@ unsigned List::run()
         dir = temp == "asc" ? OrderDir::Asc : OrderDir::Desc;
     }
 
-    pack::Map<pack::ObjectList<Info>> ret;
-
-    auto& val = ret.append(*assetType + "s");
-
-    // Get data
-    auto allAssetsShort = AssetManager::getItems(*assetType, subtypes, order, dir);
-    if (!allAssetsShort) {
-        throw rest::errors::Internal(allAssetsShort.error());
-    }
-
-    for (const auto& [id, name] : *allAssetsShort) {
-        auto assetNames = db::idToNameExtName(id);
-        if (!assetNames) {
-            throw rest::errors::Internal("Database failure"_tr);
+    // repeated listings are served from the cache, identical ones asked at the same time are computed once
+    auto binary = BinaryWriter::negotiate(m_request.header("Accept"));
+    auto sorted = subtypes;
+    std::sort(sorted.begin(), sorted.end());
+    auto target = DbPool::instance().readTarget(user.login());
+    auto key    = fmt::format("list|{}|{}|{}|{}|{}|{}|{}", int(user.profile()), int(target), binary ? int(*binary) : -1,
+        *assetType, implode(sorted, ","), order, int(dir));
+
+    auto compute = [&]() {
+        pack::Map<pack::ObjectList<Info>> ret;
+
+        auto& val = ret.append(*assetType + "s");
+
+        // Get data
+        metrics::Scope       dbScope(metrics::Phase::Db);
+        DbPool::Lease        lease(target);
+        fty::db::Connection& conn = lease.connection();
+
+        auto allAssetsShort = [&]() {
+            metrics::DbCall call;
+            return AssetManager::getItems(*assetType, subtypes, order, dir);
+        }();
+        if (!allAssetsShort) {
+            throw rest::errors::Internal(allAssetsShort.error());
         }
-
-        auto& ins = val.append();
-        ins.id    = id;
-        ins.name  = assetNames->second;
+        metrics::rows(allAssetsShort->size());
+
+        // list, then the names of all the assets of the type
+        measure.budget(2);
+        auto names = batch::extNamesOfType(conn, persist::type_to_typeid(*assetType));
+
+        for (const auto& [id, name] : *allAssetsShort) {
+            auto& ins = val.append();
+            ins.id    = id;
+            if (auto found = names.find(id); found != names.end()) {
+                ins.name = found->second;
+            } else {
+                ins.name = name;
+            }
+        }
+        dbScope.stop();
+
+        metrics::Scope      serialization(metrics::Phase::Serialization);
+        SingleFlight::Reply reply;
+        reply.status = HTTP_OK;
+        if (binary) {
+            BinaryWriter out(*binary);
+            write(out, ret, false);
+            reply.contentType = out.contentType();
+            reply.body        = out.data();
+        } else {
+            reply.body = *pack::json::serialize(ret);
+        }
+        return reply;
+    };
+
+    auto reply = ResponseCache::instance().run(key, compute, target);
+    // the format follows the Accept header, caches in between must keep the replies apart
+    m_reply.setHeader("Vary:", "Accept");
+    if (!reply->contentType.empty()) {
+        m_reply.setContentType(reply->contentType);
     }
+    m_reply << reply->body;
 
-    m_reply << *pack::json::serialize(ret);
-    return HTTP_OK;
+    return reply->status;
 }
 
 } // namespace fty::asset
@@ -0,0 +1,202 @@
+/*  ====================================================================================================================
+    message-bus.cpp - Message bus used by the handlers
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "message-bus.h"
+#include "asset-events.h"
+#include "config.h"
+#include <asset/asset-notifications.h>
+#include <atomic>
+#include <fmt/format.h>
+#include <fty_commands_dto.h>
+#include <fty_common_mlm_utils.h>
+#include <fty_log.h>
+#include <mutex>
+#include <pack/pack.h>
+#include <random>
+#include <thread>
+
+namespace fty::asset {
+
+std::unique_ptr<messagebus::MessageBus> messageBus()
+{
+    std::unique_ptr<messagebus::MessageBus> bus;
+    if (config::localBus()) {
+        bus = std::make_unique<LocalBus>();
+    } else {
+        bus.reset(messagebus::MlmMessageBus(MLM_ENDPOINT, messagebus::getClientId("tntnet")));
+    }
+    bus->connect();
+    return bus;
+}
+
+template <typename Payload>
+static void watch(messagebus::MessageBus& bus, const std::string& topic, events::Type type)
+{
+    bus.subscribe(topic, [type](messagebus::Message message) {
+        if (message.userData().empty()) {
+            return;
+        }
+        Payload light;
+        if (auto ret = pack::json::deserialize(message.userData().front(), light); !ret) {
+            logWarn("Asset stream notification not understood: {}", ret.error());
+            return;
+        }
+
+        events::Event event{type};
+        event.name     = light.value();
+        event.external = true;
+        events::publish(event);
+    });
+}
+
+void watchAssetStreams()
+{
+    static std::once_flag once;
+    std::call_once(once, []() {
+        try {
+            // kept connected for the life of the library
+            static auto bus = messageBus();
+            watch<notification::created::PayloadLight>(*bus, notification::created::Topic::Light, events::Type::Created);
+            watch<notification::updated::PayloadLight>(*bus, notification::updated::Topic::Light, events::Type::Updated);
+            watch<notification::deleted::PayloadLight>(*bus, notification::deleted::Topic::Light, events::Type::Deleted);
+        } catch (const std::exception& e) {
+            logError("Asset streams not watched, changes of other agents are seen when the indexes expire: {}", e.what());
+        }
+    });
+}
+
+// =========================================================================================================================================
+
+static std::atomic<uint64_t> requestCount{0};
+static std::atomic<uint64_t> publishCount{0};
+
+static void wait()
+{
+    auto latency = config::localBusLatency();
+    if (auto jitter = config::localBusJitter(); jitter.count() > 0) {
+        static thread_local std::mt19937 gen{std::random_device{}()};
+        std::uniform_int_distribution<long> dist(0, long(jitter.count()));
+        latency += std::chrono::milliseconds(dist(gen));
+    }
+    if (latency.count() > 0) {
+        std::this_thread::sleep_for(latency);
+    }
+}
+
+void LocalBus::connect()
+{
+}
+
+void LocalBus::publish(const std::string& /*topic*/, const messagebus::Message& /*message*/)
+{
+    publishCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LocalBus::subscribe(const std::string& /*topic*/, messagebus::MessageListener /*messageListener*/)
+{
+}
+
+void LocalBus::unsubscribe(const std::string& /*topic*/, messagebus::MessageListener /*messageListener*/)
+{
+}
+
+void LocalBus::sendRequest(const std::string& /*requestQueue*/, const messagebus::Message& /*message*/)
+{
+    requestCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LocalBus::sendRequest(
+    const std::string& /*requestQueue*/, const messagebus::Message& message, messagebus::MessageListener messageListener)
+{
+    requestCount.fetch_add(1, std::memory_order_relaxed);
+    wait();
+    messageListener(reply(message));
+}
+
+void LocalBus::sendReply(const std::string& /*replyQueue*/, const messagebus::Message& /*message*/)
+{
+}
+
+void LocalBus::receive(const std::string& /*queue*/, messagebus::MessageListener /*messageListener*/)
+{
+}
+
+messagebus::Message LocalBus::request(const std::string& /*requestQueue*/, const messagebus::Message& message, int /*receiveTimeOut*/)
+{
+    requestCount.fetch_add(1, std::memory_order_relaxed);
+    wait();
+    return reply(message);
+}
+
+uint64_t LocalBus::requests()
+{
+    return requestCount.load(std::memory_order_relaxed);
+}
+
+uint64_t LocalBus::publishes()
+{
+    return publishCount.load(std::memory_order_relaxed);
+}
+
+void LocalBus::published()
+{
+    publishCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::string LocalBus::exposition()
+{
+    // clang-format off
+    return fmt::format(
+        "# HELP fty_asset_rest_local_bus_requests_total Requests answered by the local message bus\n"
+        "# TYPE fty_asset_rest_local_bus_requests_total counter\n"
+        "fty_asset_rest_local_bus_requests_total {}\n"
+        "# HELP fty_asset_rest_local_bus_publishes_total Messages published on the local message bus\n"
+        "# TYPE fty_asset_rest_local_bus_publishes_total counter\n"
+        "fty_asset_rest_local_bus_publishes_total {}\n",
+        requests(), publishes());
+    // clang-format on
+}
+
+messagebus::Message LocalBus::reply(const messagebus::Message& message)
+{
+    auto meta = message.metaData();
+
+    messagebus::Message ret;
+    ret.metaData()[messagebus::Message::CORRELATION_ID] = meta[messagebus::Message::CORRELATION_ID];
+    ret.metaData()[messagebus::Message::SUBJECT]        = meta[messagebus::Message::SUBJECT];
+    ret.metaData()[messagebus::Message::FROM]           = meta[messagebus::Message::TO];
+    ret.metaData()[messagebus::Message::TO]             = meta[messagebus::Message::FROM];
+    ret.metaData()[messagebus::Message::STATUS]         = "ok";
+
+    if (meta[messagebus::Message::SUBJECT] == "GetCommands") {
+        dto::commands::GetCommandsReplyDto commands;
+        for (const char* name : {"load.off", "load.on", "load.cycle"}) {
+            dto::commands::CommandDescription command;
+            command.command     = name;
+            command.description = name;
+            commands.push_back(command);
+        }
+        ret.userData() << commands;
+    }
+    return ret;
+}
+
+} // namespace fty::asset
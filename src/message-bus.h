@@ -0,0 +1,101 @@
+/*  ====================================================================================================================
+    message-bus.h - Message bus used by the handlers
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include "config.h"
+#include <asset/asset-configure-inform.h>
+#include <cstdint>
+#include <fty_common_messagebus.h>
+#include <memory>
+#include <string>
+
+namespace fty::asset {
+
+/// Connected message bus for a request of the handler.
+/// Malamute normally, the local stand-in when it is enabled in the config.
+std::unique_ptr<messagebus::MessageBus> messageBus();
+
+/// Publishes the changes announced on the asset streams as external events (see events::Event), from the first call on.
+/// Called by the in-memory indexes, which otherwise only see the changes of other agents when they expire.
+void watchAssetStreams();
+
+/// In-process stand-in of malamute and fty-nut-command, used to load-test the handlers without the other agents.
+/// Requests are answered with "ok" after the configured latency, GetCommands with a fixed list of commands.
+/// Published messages, configure messages and stream notifications (see bus::) are only counted.
+class LocalBus : public messagebus::MessageBus
+{
+public:
+    void connect() override;
+
+    void publish(const std::string& topic, const messagebus::Message& message) override;
+    void subscribe(const std::string& topic, messagebus::MessageListener messageListener) override;
+    void unsubscribe(const std::string& topic, messagebus::MessageListener messageListener) override;
+
+    void sendRequest(const std::string& requestQueue, const messagebus::Message& message) override;
+    void sendRequest(
+        const std::string& requestQueue, const messagebus::Message& message, messagebus::MessageListener messageListener) override;
+    void sendReply(const std::string& replyQueue, const messagebus::Message& message) override;
+    void receive(const std::string& queue, messagebus::MessageListener messageListener) override;
+
+    messagebus::Message request(const std::string& requestQueue, const messagebus::Message& message, int receiveTimeOut) override;
+
+public:
+    /// Counters over all the instances
+    static uint64_t requests();
+    static uint64_t publishes();
+
+    /// Counts a message published without an instance (configure message, stream notification)
+    static void published();
+
+    /// Counters in the Prometheus text format
+    static std::string exposition();
+
+private:
+    messagebus::Message reply(const messagebus::Message& message);
+};
+
+namespace bus {
+
+    /// sendConfigure() of the asset library, only counted when the local bus is enabled
+    template <typename... Args>
+    auto sendConfigure(const Args&... args) -> decltype(fty::asset::sendConfigure(args...))
+    {
+        if (config::localBus()) {
+            LocalBus::published();
+            return {};
+        }
+        return fty::asset::sendConfigure(args...);
+    }
+
+    /// sendStreamNotification() of the asset library, only counted when the local bus is enabled
+    template <typename... Args>
+    auto sendStreamNotification(const Args&... args) -> decltype(fty::asset::sendStreamNotification(args...))
+    {
+        if (config::localBus()) {
+            LocalBus::published();
+            return {};
+        }
+        return fty::asset::sendStreamNotification(args...);
+    }
+
+} // namespace bus
+
+} // namespace fty::asset
@@ -0,0 +1,31 @@
+#include "metrics-get.h"
+#include "config.h"
+#include "message-bus.h"
+#include "metrics.h"
+#include <fty/rest/component.h>
+
+namespace fty::asset {
+
+unsigned MetricsGet::run()
+{
+    rest::User user(m_request);
+    if (auto ret = checkPermissions(user.profile(), m_permissions); !ret) {
+        throw rest::Error(ret.error());
+    }
+
+    if (m_request.type() != rest::Request::Type::Get) {
+        throw rest::errors::MethodNotAllowed(m_request.typeStr());
+    }
+
+    m_reply.setContentType("text/plain; version=0.0.4");
+    m_reply << metrics::exposition();
+    if (config::localBus()) {
+        m_reply << LocalBus::exposition();
+    }
+
+    return HTTP_OK;
+}
+
+} // namespace fty::asset
+
+registerHandler(fty::asset::MetricsGet)
@@ -0,0 +1,421 @@
+/*  ====================================================================================================================
+    metrics.cpp - Latency statistics of the handlers
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "metrics.h"
+#include "config.h"
+#include <exception>
+#include <fmt/format.h>
+#include <fty_log.h>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace fty::asset::metrics {
+
+const char* phaseName(Phase phase)
+{
+    switch (phase) {
+        case Phase::Permissions:
+            return "permissions";
+        case Phase::Db:
+            return "db";
+        case Phase::Serialization:
+            return "serialization";
+        case Phase::Bus:
+            return "bus";
+        case Phase::Admission:
+            return "admission";
+        case Phase::Count:
+            break;
+    }
+    return "unknown";
+}
+
+// =========================================================================================================================================
+
+void Histogram::record(Clock::duration duration)
+{
+    uint64_t us = uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+
+    size_t bucket = 0;
+    while (bucket < Bounds.size() && us > Bounds[bucket]) {
+        ++bucket;
+    }
+
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_sumUs.fetch_add(us, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+Histogram::Counts Histogram::counts() const
+{
+    Counts ret;
+    for (size_t i = 0; i < ret.size(); ++i) {
+        ret[i] = m_buckets[i].load(std::memory_order_relaxed);
+    }
+    return ret;
+}
+
+uint64_t Histogram::count() const
+{
+    return m_count.load(std::memory_order_relaxed);
+}
+
+double Histogram::sumSeconds() const
+{
+    return double(m_sumUs.load(std::memory_order_relaxed)) / 1e6;
+}
+
+double Histogram::quantile(double q) const
+{
+    auto     buckets = counts();
+    uint64_t total   = 0;
+    for (auto cnt : buckets) {
+        total += cnt;
+    }
+    if (!total) {
+        return 0;
+    }
+
+    double   rank = q * double(total);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        if (buckets[i] && double(seen + buckets[i]) >= rank) {
+            // +Inf bucket has no upper bound, report its lower one
+            if (i == Bounds.size()) {
+                return double(Bounds.back()) / 1e6;
+            }
+            double lower = i ? double(Bounds[i - 1]) : 0.;
+            double upper = double(Bounds[i]);
+            return (lower + (upper - lower) * (rank - double(seen)) / double(buckets[i])) / 1e6;
+        }
+        seen += buckets[i];
+    }
+    return double(Bounds.back()) / 1e6;
+}
+
+// =========================================================================================================================================
+
+struct Registry
+{
+    std::mutex                                       mutex;
+    std::map<std::string, std::unique_ptr<Endpoint>> endpoints;
+};
+
+static Registry& registry()
+{
+    static Registry inst;
+    return inst;
+}
+
+Endpoint& endpoint(const std::string& name)
+{
+    auto&                       reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    auto& ptr = reg.endpoints[name];
+    if (!ptr) {
+        ptr       = std::make_unique<Endpoint>();
+        ptr->name = name;
+    }
+    return *ptr;
+}
+
+// =========================================================================================================================================
+
+static thread_local Request* currentRequest = nullptr;
+
+Request::Request(Endpoint& endpoint)
+    : m_endpoint(endpoint)
+    , m_start(Clock::now())
+    , m_exceptions(std::uncaught_exceptions())
+    , m_parent(currentRequest)
+{
+    currentRequest = this;
+}
+
+Request::~Request()
+{
+    currentRequest = m_parent;
+
+    auto elapsed = Clock::now() - m_start;
+
+    m_endpoint.total.record(elapsed);
+    for (size_t i = 0; i < m_phases.size(); ++i) {
+        if (m_phases[i] != Clock::duration::zero()) {
+            m_endpoint.phases[i].record(m_phases[i]);
+        }
+    }
+
+    bool failed = std::uncaught_exceptions() > m_exceptions;
+    if (failed) {
+        m_endpoint.errors.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_endpoint.dbCalls.fetch_add(m_dbCalls, std::memory_order_relaxed);
+    if (m_rejected) {
+        m_endpoint.rejected.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (m_coalesced) {
+        m_endpoint.coalesced.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (m_cached) {
+        (*m_cached ? m_endpoint.cacheHits : m_endpoint.cacheMisses).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool overBudget = m_budget && m_dbCalls > *m_budget;
+    if (overBudget) {
+        m_endpoint.overBudget.fetch_add(1, std::memory_order_relaxed);
+        logError("endpoint {} made {} database calls, expected at most {}", m_endpoint.name, m_dbCalls, *m_budget);
+    }
+
+    auto dbMs = std::chrono::duration_cast<std::chrono::milliseconds>(m_dbTime).count();
+
+    if (m_header && config::debugHeaders()) {
+        m_header("X-Db-Calls:", std::to_string(m_dbCalls));
+        m_header("X-Db-Time-Ms:", std::to_string(dbMs));
+        m_header("X-Db-Rows:", std::to_string(m_rows));
+        if (m_budget) {
+            m_header("X-Db-Call-Budget:", std::to_string(*m_budget));
+        }
+    }
+
+    auto slow = config::slowRequest();
+    if (slow.count() > 0 && elapsed >= slow) {
+        std::string params;
+        for (const auto& [name, value] : m_params) {
+            params += fmt::format(" {}=\"{}\"", name, value);
+        }
+        logWarn("slow request: endpoint=\"{}\" duration_ms={} db_calls={} db_ms={} rows={} failed={}{}", m_endpoint.name,
+            std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), m_dbCalls, dbMs, m_rows, failed, params);
+    }
+}
+
+void Request::add(Phase phase, Clock::duration duration)
+{
+    m_phases[size_t(phase)] += duration;
+}
+
+void Request::dbCall(Clock::duration duration, size_t rows)
+{
+    ++m_dbCalls;
+    m_dbTime += duration;
+    m_rows += rows;
+}
+
+void Request::rows(size_t count)
+{
+    m_rows += count;
+}
+
+void Request::param(const std::string& name, const std::string& value)
+{
+    m_params.emplace_back(name, value);
+}
+
+void Request::budget(uint64_t calls)
+{
+    m_budget = calls;
+}
+
+void Request::rejected()
+{
+    m_rejected = true;
+}
+
+void Request::coalesced()
+{
+    m_coalesced = true;
+}
+
+void Request::cached(bool hit)
+{
+    m_cached = hit;
+}
+
+Request* Request::current()
+{
+    return currentRequest;
+}
+
+// =========================================================================================================================================
+
+Scope::Scope(Phase phase)
+    : m_phase(phase)
+    , m_start(Clock::now())
+{
+}
+
+Scope::~Scope()
+{
+    stop();
+}
+
+void Scope::stop()
+{
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+
+    if (auto req = Request::current()) {
+        req->add(m_phase, Clock::now() - m_start);
+    }
+}
+
+// =========================================================================================================================================
+
+// calls made from row callbacks of another call are counted, but their time is already part of the outer one
+static thread_local int callDepth = 0;
+
+DbCall::DbCall()
+    : m_start(Clock::now())
+    , m_nested(callDepth++ > 0)
+{
+}
+
+DbCall::~DbCall()
+{
+    --callDepth;
+    if (auto req = Request::current()) {
+        req->dbCall(m_nested ? Clock::duration::zero() : Clock::now() - m_start, m_rows);
+    }
+}
+
+void DbCall::rows(size_t count)
+{
+    m_rows += count;
+}
+
+void rows(size_t count)
+{
+    if (auto req = Request::current()) {
+        req->rows(count);
+    }
+}
+
+void rejected()
+{
+    if (auto req = Request::current()) {
+        req->rejected();
+    }
+}
+
+void coalesced()
+{
+    if (auto req = Request::current()) {
+        req->coalesced();
+    }
+}
+
+void cached(bool hit)
+{
+    if (auto req = Request::current()) {
+        req->cached(hit);
+    }
+}
+
+// =========================================================================================================================================
+
+static void histogram(std::string& out, const std::string& metric, const std::string& labels, const Histogram& hist)
+{
+    auto     buckets = hist.counts();
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        cumulative += buckets[i];
+        std::string le = i < Histogram::Bounds.size() ? fmt::format("{}", double(Histogram::Bounds[i]) / 1e6) : "+Inf";
+        out += fmt::format("{}_bucket{{{},le=\"{}\"}} {}\n", metric, labels, le, cumulative);
+    }
+    out += fmt::format("{}_sum{{{}}} {}\n", metric, labels, hist.sumSeconds());
+    out += fmt::format("{}_count{{{}}} {}\n", metric, labels, cumulative);
+}
+
+std::string exposition()
+{
+    static const std::array<double, 3> quantiles = {0.5, 0.95, 0.99};
+
+    std::string requests =
+        "# HELP fty_asset_rest_request_duration_seconds Duration of the requests\n"
+        "# TYPE fty_asset_rest_request_duration_seconds histogram\n";
+    std::string latency =
+        "# HELP fty_asset_rest_request_latency_seconds Quantiles of the request duration\n"
+        "# TYPE fty_asset_rest_request_latency_seconds gauge\n";
+    std::string phases =
+        "# HELP fty_asset_rest_phase_duration_seconds Time spent per request in a phase of the handler\n"
+        "# TYPE fty_asset_rest_phase_duration_seconds histogram\n";
+    std::string errors =
+        "# HELP fty_asset_rest_request_errors_total Requests finished with an error\n"
+        "# TYPE fty_asset_rest_request_errors_total counter\n";
+    std::string calls =
+        "# HELP fty_asset_rest_db_calls_total Database calls made by the requests, a library helper is one call\n"
+        "# TYPE fty_asset_rest_db_calls_total counter\n";
+    std::string budget =
+        "# HELP fty_asset_rest_db_call_budget_exceeded_total Requests making more database calls than expected\n"
+        "# TYPE fty_asset_rest_db_call_budget_exceeded_total counter\n";
+    std::string rejected =
+        "# HELP fty_asset_rest_rejected_total Heavy requests turned away by the admission control\n"
+        "# TYPE fty_asset_rest_rejected_total counter\n";
+    std::string coalesced =
+        "# HELP fty_asset_rest_coalesced_total Requests answered with the reply of an identical one running at the same time\n"
+        "# TYPE fty_asset_rest_coalesced_total counter\n";
+    std::string cache =
+        "# HELP fty_asset_rest_cache_requests_total Requests looking for their reply in the response cache\n"
+        "# TYPE fty_asset_rest_cache_requests_total counter\n";
+    std::string hitRatio =
+        "# HELP fty_asset_rest_cache_hit_ratio Share of the requests answered from the response cache\n"
+        "# TYPE fty_asset_rest_cache_hit_ratio gauge\n";
+
+    auto&                       reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    for (const auto& [name, ep] : reg.endpoints) {
+        std::string labels = fmt::format("endpoint=\"{}\"", name);
+
+        histogram(requests, "fty_asset_rest_request_duration_seconds", labels, ep->total);
+        for (auto q : quantiles) {
+            latency += fmt::format(
+                "fty_asset_rest_request_latency_seconds{{{},quantile=\"{}\"}} {}\n", labels, q, ep->total.quantile(q));
+        }
+        for (size_t i = 0; i < ep->phases.size(); ++i) {
+            histogram(phases, "fty_asset_rest_phase_duration_seconds",
+                fmt::format("{},phase=\"{}\"", labels, phaseName(Phase(i))), ep->phases[i]);
+        }
+        errors += fmt::format("fty_asset_rest_request_errors_total{{{}}} {}\n", labels, ep->errors.load(std::memory_order_relaxed));
+        calls += fmt::format("fty_asset_rest_db_calls_total{{{}}} {}\n", labels, ep->dbCalls.load(std::memory_order_relaxed));
+        budget += fmt::format(
+            "fty_asset_rest_db_call_budget_exceeded_total{{{}}} {}\n", labels, ep->overBudget.load(std::memory_order_relaxed));
+        rejected += fmt::format("fty_asset_rest_rejected_total{{{}}} {}\n", labels, ep->rejected.load(std::memory_order_relaxed));
+        coalesced +=
+            fmt::format("fty_asset_rest_coalesced_total{{{}}} {}\n", labels, ep->coalesced.load(std::memory_order_relaxed));
+
+        // only endpoints using the cache
+        uint64_t hits   = ep->cacheHits.load(std::memory_order_relaxed);
+        uint64_t misses = ep->cacheMisses.load(std::memory_order_relaxed);
+        if (hits + misses) {
+            cache += fmt::format("fty_asset_rest_cache_requests_total{{{},result=\"hit\"}} {}\n", labels, hits);
+            cache += fmt::format("fty_asset_rest_cache_requests_total{{{},result=\"miss\"}} {}\n", labels, misses);
+            hitRatio += fmt::format("fty_asset_rest_cache_hit_ratio{{{}}} {}\n", labels, double(hits) / double(hits + misses));
+        }
+    }
+
+    return requests + latency + phases + errors + calls + budget + rejected + coalesced + cache + hitRatio;
+}
+
+} // namespace fty::asset::metrics
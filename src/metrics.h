@@ -0,0 +1,214 @@
+/*  ====================================================================================================================
+    metrics.h - Latency statistics of the handlers
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fty::asset::metrics {
+
+using Clock = std::chrono::steady_clock;
+
+enum class Phase
+{
+    Permissions,
+    Db,
+    Serialization,
+    Bus,
+    Admission,
+    Count
+};
+
+const char* phaseName(Phase phase);
+
+/// Latency histogram, updated without locks
+class Histogram
+{
+public:
+    /// Upper bounds of the buckets in microseconds, the last (implicit) bucket is +Inf
+    static constexpr std::array<uint64_t, 19> Bounds = {50, 100, 250, 500, 1'000, 2'500, 5'000, 10'000, 25'000, 50'000,
+        100'000, 250'000, 500'000, 1'000'000, 2'500'000, 5'000'000, 10'000'000, 30'000'000, 60'000'000};
+
+    using Counts = std::array<uint64_t, Bounds.size() + 1>;
+
+public:
+    void record(Clock::duration duration);
+
+    /// Non cumulative counts per bucket
+    Counts   counts() const;
+    uint64_t count() const;
+    double   sumSeconds() const;
+
+    /// Quantile (0..1) in seconds, interpolated within the bucket
+    double quantile(double q) const;
+
+private:
+    std::array<std::atomic<uint64_t>, Bounds.size() + 1> m_buckets{};
+    std::atomic<uint64_t>                                m_count{0};
+    std::atomic<uint64_t>                                m_sumUs{0};
+};
+
+struct Endpoint
+{
+    std::string                                     name;
+    Histogram                                       total;
+    std::array<Histogram, size_t(Phase::Count)>     phases;
+    std::atomic<uint64_t>                           errors{0};
+    std::atomic<uint64_t>                           dbCalls{0};
+    std::atomic<uint64_t>                           overBudget{0};
+    std::atomic<uint64_t>                           rejected{0};
+    std::atomic<uint64_t>                           coalesced{0};
+    std::atomic<uint64_t>                           cacheHits{0};
+    std::atomic<uint64_t>                           cacheMisses{0};
+};
+
+/// Statistics of the endpoint, created on first use. Handlers keep the reference in a static variable.
+Endpoint& endpoint(const std::string& name);
+
+/// Measures the request handled in the current thread, created at the beginning of the handler
+class Request
+{
+public:
+    explicit Request(Endpoint& endpoint);
+    ~Request();
+
+    /// Also reports database statistics in the headers of the reply when debug headers are enabled
+    template <typename Reply>
+    Request(Endpoint& endpoint, Reply& reply)
+        : Request(endpoint)
+    {
+        m_header = [&reply](const std::string& name, const std::string& value) {
+            reply.setHeader(name, value);
+        };
+    }
+
+    Request(const Request&) = delete;
+    Request& operator=(const Request&) = delete;
+
+    /// Adds time spent in a phase of this request
+    void add(Phase phase, Clock::duration duration);
+
+    /// Adds a database call (and the rows it returned) made by this request
+    void dbCall(Clock::duration duration, size_t rows);
+
+    /// Adds rows returned by the last call, for calls reporting rows through a callback
+    void rows(size_t count);
+
+    /// Request parameter shown in the slow request log
+    void param(const std::string& name, const std::string& value);
+
+    /// Number of database calls the request is expected to make at most.
+    /// Making more is a regression (typically a call per item): it is logged and counted.
+    void budget(uint64_t calls);
+
+    /// The request was turned away by the admission control
+    void rejected();
+
+    /// The request shared the reply of an identical one running at the same time
+    void coalesced();
+
+    /// The request looked for its reply in the response cache, and found it or not
+    void cached(bool hit);
+
+    /// Request measured in the current thread, if any
+    static Request* current();
+
+private:
+    using HeaderFunc = std::function<void(const std::string&, const std::string&)>;
+
+    Endpoint&                                         m_endpoint;
+    Clock::time_point                                 m_start;
+    int                                               m_exceptions;
+    std::array<Clock::duration, size_t(Phase::Count)> m_phases{};
+    Request*                                          m_parent;
+    uint64_t                                          m_dbCalls = 0;
+    uint64_t                                          m_rows    = 0;
+    Clock::duration                                   m_dbTime{};
+    std::vector<std::pair<std::string, std::string>>  m_params;
+    HeaderFunc                                        m_header;
+    std::optional<uint64_t>                           m_budget;
+    bool                                              m_rejected  = false;
+    bool                                              m_coalesced = false;
+    std::optional<bool>                               m_cached;
+};
+
+/// Measures a phase of the current request until destroyed or stopped
+class Scope
+{
+public:
+    explicit Scope(Phase phase);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    void stop();
+
+private:
+    Phase             m_phase;
+    Clock::time_point m_start;
+    bool              m_running = true;
+};
+
+/// Counts one database call of the current request, timed from construction to destruction.
+/// Database access goes through libraries without hooks, so call sites are marked with it. A call is one statement
+/// when it runs SQL of this library, but any number of them when it goes to a library helper (AssetManager...): the
+/// statements run inside are not seen.
+class DbCall
+{
+public:
+    DbCall();
+    ~DbCall();
+
+    DbCall(const DbCall&) = delete;
+    DbCall& operator=(const DbCall&) = delete;
+
+    /// Rows returned by the call
+    void rows(size_t count);
+
+private:
+    Clock::time_point m_start;
+    bool              m_nested;
+    size_t            m_rows = 0;
+};
+
+/// Adds rows to the current request, if any
+void rows(size_t count);
+
+/// Marks the current request, if any, as turned away by the admission control
+void rejected();
+
+/// Marks the current request, if any, as sharing the reply of an identical one
+void coalesced();
+
+/// Marks the current request, if any, as answered from the response cache or not
+void cached(bool hit);
+
+/// All the statistics in Prometheus text format
+std::string exposition();
+
+} // namespace fty::asset::metrics
@@ -0,0 +1,231 @@
+#include "placement.h"
+#include "batch-read.h"
+#include "db-pool.h"
+#include "metrics.h"
+#include "rack-index.h"
+#include <asset/asset-db2.h>
+#include <asset/asset-helpers.h>
+#include <fty/rest/component.h>
+#include <fty_common_asset_types.h>
+#include <fty_common_db_connection.h>
+
+namespace fty::asset {
+
+struct PlacementRequest : public pack::Node
+{
+    pack::String     id        = FIELD("asset_id");
+    pack::UInt32     usize     = FIELD("asset_size");
+    pack::StringList racks     = FIELD("racks");
+    pack::String     container = FIELD("container");
+    pack::Bool       bestFit   = FIELD("best_fit");
+
+    using pack::Node::Node;
+    META(PlacementRequest, id, usize, racks, container, bestFit);
+};
+
+struct FreeRange : public pack::Node
+{
+    pack::UInt32 position = FIELD("asset_position");
+    pack::UInt32 size     = FIELD("size");
+
+    using pack::Node::Node;
+    META(FreeRange, position, size);
+};
+
+struct RackPlaces : public pack::Node
+{
+    pack::String                rackId   = FIELD("rack_id");
+    pack::UInt32                rackSize = FIELD("rack_size");
+    pack::ObjectList<FreeRange> free     = FIELD("free");
+
+    using pack::Node::Node;
+    META(RackPlaces, rackId, rackSize, free);
+};
+
+struct Placement : public pack::Node
+{
+    pack::ObjectList<RackPlaces> racks        = FIELD("racks");
+    pack::String                 bestRackId   = FIELD("best_rack_id");
+    pack::UInt32                 bestPosition = FIELD("best_position");
+
+    using pack::Node::Node;
+    META(Placement, racks, bestRackId, bestPosition);
+};
+
+// =========================================================================================================================================
+
+// Racks by internal name, resolved in one query per batch::Size racks
+static std::map<uint32_t, std::string> racksByName(fty::db::Connection& conn, const pack::StringList& names)
+{
+    std::vector<std::string> list;
+    for (const auto& name : names) {
+        list.push_back(name);
+    }
+    auto found = batch::named(conn, list);
+
+    std::map<uint32_t, std::string> ret;
+    for (const auto& name : list) {
+        auto rack = found.find(name);
+        if (rack == found.end()) {
+            throw rest::errors::RequestParamBad("racks", name, "existing rack id"_tr);
+        }
+        if (rack->second.typeId != persist::type_to_typeid("rack")) {
+            throw rest::errors::RequestParamBad("racks", name, "rack id"_tr);
+        }
+        ret.emplace(rack->second.id, name);
+    }
+    return ret;
+}
+
+// All the racks somewhere in the container
+static std::map<uint32_t, std::string> racksInContainer(fty::db::Connection& conn, const std::string& container)
+{
+    uint32_t containerId = 0;
+    if (auto ret = checkElementIdentifier("container", container)) {
+        containerId = *ret;
+    } else {
+        throw rest::errors::RequestParamBad("container", container, "valid container id"_tr);
+    }
+
+    db::asset::select::Filter flt;
+    flt.types = {persist::type_to_typeid("rack")};
+
+    db::asset::select::Order order;
+    order.field = "name";
+    order.dir   = db::asset::select::Order::Dir::Asc;
+
+    std::map<uint32_t, std::string> ret;
+    metrics::DbCall                 call;
+    auto                            list = db::asset::select::itemsByContainer(
+        conn, containerId,
+        [&](const fty::db::Row& row) {
+            call.rows(1);
+            ret.emplace(row.get<uint32_t>("id"), row.get("name"));
+        },
+        flt, order);
+    if (!list) {
+        throw rest::errors::Internal(list.error());
+    }
+    return ret;
+}
+
+// =========================================================================================================================================
+
+unsigned PlacementSearch::run()
+{
+    static auto&     stats = metrics::endpoint("asset/placement");
+    metrics::Request measure(stats, m_reply);
+
+    metrics::Scope permissions(metrics::Phase::Permissions);
+    rest::User     user(m_request);
+    if (auto ret = checkPermissions(user.profile(), m_permissions); !ret) {
+        throw rest::Error(ret.error());
+    }
+    permissions.stop();
+
+    if (m_request.type() != rest::Request::Type::Post) {
+        throw rest::errors::MethodNotAllowed(m_request.typeStr());
+    }
+
+    std::string json = m_request.body();
+    if (json.empty()) {
+        throw rest::errors::BadInput("Payload is empty"_tr);
+    }
+
+    metrics::Scope   parsing(metrics::Phase::Serialization);
+    PlacementRequest input;
+    if (auto ret = pack::json::deserialize(json, input); !ret) {
+        throw rest::errors::BadInput(ret.error());
+    }
+    parsing.stop();
+
+    if (!input.usize.hasValue() || input.usize.value() == 0) {
+        throw rest::errors::BadInput("U-size is not set");
+    }
+
+    if ((input.racks.size() == 0) == input.container.empty()) {
+        throw rest::errors::BadInput("Either list of racks or container must be set");
+    }
+
+    // asset lookup, racks (one statement per batch::Size listed ones), occupancy of all of them
+    measure.budget(2 + (input.racks.size() ? batch::statements(input.racks.size()) : 1));
+
+    metrics::Scope       dbScope(metrics::Phase::Db);
+    DbPool::Lease        lease;
+    fty::db::Connection& conn = lease.connection();
+
+    uint32_t id = 0;
+    if (input.id.hasValue() && !input.id.empty()) {
+        metrics::DbCall call;
+        if (auto tmp = db::nameToAssetId(input.id)) {
+            id = convert<uint32_t>(*tmp);
+        } else {
+            throw rest::errors::RequestParamBad("asset_id", input.id.value(), "asset name");
+        }
+    }
+
+    std::map<uint32_t, std::string> racks;
+    try {
+        racks = input.racks.size() == 0 ? racksInContainer(conn, input.container.value()) : racksByName(conn, input.racks);
+    } catch (const rest::Error&) {
+        throw;
+    } catch (const std::exception& e) {
+        throw rest::errors::Internal(e.what());
+    }
+
+    std::vector<uint32_t> ids;
+    for (const auto& [rackId, name] : racks) {
+        ids.push_back(rackId);
+    }
+
+    std::map<uint32_t, RackIndex::RackPtr> occupancy;
+    try {
+        occupancy = RackIndex::instance().racks(ids);
+    } catch (const std::exception& e) {
+        throw rest::errors::Internal(e.what());
+    }
+    dbScope.stop();
+
+    Placement            result;
+    RackOccupancy::Range best;
+    std::string          bestRack;
+
+    for (const auto& [rackId, name] : racks) {
+        const auto& rack   = *occupancy[rackId];
+        auto        ranges = rack.freeRanges(input.usize.value(), id);
+
+        for (const auto& range : ranges) {
+            // best fit is the smallest free range the device fits in
+            if (bestRack.empty() || range.size < best.size) {
+                best     = range;
+                bestRack = name;
+            }
+        }
+
+        if (input.bestFit.value()) {
+            continue;
+        }
+
+        auto& places    = result.racks.append();
+        places.rackId   = name;
+        places.rackSize = rack.size();
+        for (const auto& range : ranges) {
+            auto& free    = places.free.append();
+            free.position = range.position;
+            free.size     = range.size;
+        }
+    }
+
+    if (!bestRack.empty()) {
+        result.bestRackId   = bestRack;
+        result.bestPosition = best.position;
+    }
+
+    metrics::Scope serialization(metrics::Phase::Serialization);
+    m_reply << *pack::json::serialize(result);
+    return HTTP_OK;
+}
+
+} // namespace fty::asset
+
+registerHandler(fty::asset::PlacementSearch)
@@ -0,0 +1,296 @@
+/*  ====================================================================================================================
+    power-graph.cpp - In-memory graph of the power links
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "power-graph.h"
+#include "metrics.h"
+#include <algorithm>
+#include <fty_common_db_connection.h>
+#include <map>
+#include <set>
+
+namespace fty::asset {
+
+PowerGraph& PowerGraph::instance()
+{
+    static PowerGraph graph;
+    return graph;
+}
+
+PowerGraph::PowerGraph()
+{
+    events::subscribe([this](const events::Event& event) {
+        onEvent(event);
+    });
+}
+
+void PowerGraph::onEvent(const events::Event&)
+{
+    // events do not tell which links were changed, the graph is small enough to be reloaded
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_reset = true;
+}
+
+// =========================================================================================================================================
+
+PowerGraph::Graph PowerGraph::load(fty::db::Connection& conn)
+{
+    Graph graph;
+
+    // clang-format off
+    static const std::string linksSql = R"(
+        SELECT l.id_asset_device_src AS srcId, l.id_asset_device_dest AS destId,
+            COALESCE(l.src_out, '') AS srcSocket, COALESCE(l.dest_in, '') AS destSocket
+        FROM t_bios_asset_link l
+        INNER JOIN t_bios_asset_link_type t ON t.id_asset_link_type = l.id_asset_link_type
+        WHERE t.name = 'power chain'
+    )";
+
+    static const std::string devicesSql = R"(
+        SELECT e.id_asset_element AS id, e.name AS iname, COALESCE(ext.value, e.name) AS name,
+            e.id_type AS typeId, e.id_subtype AS subTypeId
+        FROM t_bios_asset_element e
+        LEFT JOIN t_bios_asset_ext_attributes ext ON ext.id_asset_element = e.id_asset_element AND ext.keytag = 'name'
+        WHERE e.id_asset_element IN (
+            SELECT id_asset_device_src FROM t_bios_asset_link
+            UNION
+            SELECT id_asset_device_dest FROM t_bios_asset_link
+        )
+    )";
+    // clang-format on
+
+    {
+        metrics::DbCall call;
+        for (const auto& row : conn.prepare(devicesSql).select()) {
+            call.rows(1);
+            Device dev;
+            dev.id        = row.get<uint32_t>("id");
+            dev.iname     = row.get("iname");
+            dev.name      = row.get("name");
+            dev.typeId    = row.get<uint16_t>("typeId");
+            dev.subTypeId = row.get<uint16_t>("subTypeId");
+            graph.pos.emplace(dev.id, uint32_t(graph.devices.size()));
+            graph.devices.push_back(std::move(dev));
+        }
+    }
+
+    {
+        metrics::DbCall call;
+        for (const auto& row : conn.prepare(linksSql).select()) {
+            call.rows(1);
+            Link link;
+            link.srcId      = row.get<uint32_t>("srcId");
+            link.destId     = row.get<uint32_t>("destId");
+            link.srcSocket  = row.get("srcSocket");
+            link.destSocket = row.get("destSocket");
+            // asset removed between the two queries
+            if (graph.pos.count(link.srcId) && graph.pos.count(link.destId)) {
+                graph.links.push_back(std::move(link));
+            }
+        }
+    }
+
+    // links of every device in one array, each device owning a range
+    auto index = [&](std::vector<uint32_t>& first, std::vector<uint32_t>& items, auto end) {
+        first.assign(graph.devices.size() + 1, 0);
+        for (const auto& link : graph.links) {
+            ++first[graph.pos[end(link)] + 1];
+        }
+        for (size_t pos = 1; pos < first.size(); ++pos) {
+            first[pos] += first[pos - 1];
+        }
+        std::vector<uint32_t> fill(first.begin(), first.end() - 1);
+        items.assign(graph.links.size(), 0);
+        for (uint32_t i = 0; i < graph.links.size(); ++i) {
+            items[fill[graph.pos[end(graph.links[i])]]++] = i;
+        }
+    };
+    index(graph.outFirst, graph.out, [](const Link& link) {
+        return link.srcId;
+    });
+    index(graph.inFirst, graph.in, [](const Link& link) {
+        return link.destId;
+    });
+
+    return graph;
+}
+
+PowerGraph::GraphPtr PowerGraph::graph()
+{
+    // one load at a time, other requests wait for it instead of using an outdated graph
+    std::lock_guard<std::mutex> loading(m_loadMutex);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto                        now = std::chrono::steady_clock::now();
+        if (m_graph && !m_reset && now - m_loaded < MaxAge) {
+            return m_graph;
+        }
+        m_reset  = false;
+        m_loaded = now;
+    }
+
+    try {
+        fty::db::Connection conn;
+        auto                loaded = std::make_shared<const Graph>(load(conn));
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_graph = loaded;
+        return loaded;
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_reset = true;
+        throw;
+    }
+}
+
+// =========================================================================================================================================
+
+void PowerGraph::walk(const Graph& graph, Topology& topology, uint32_t from, Direction direction, uint32_t depth)
+{
+    bool down = direction == Direction::Downstream;
+
+    const auto& first = down ? graph.outFirst : graph.inFirst;
+    const auto& items = down ? graph.out : graph.in;
+
+    // breadth first, a device is reported at its shortest distance and expanded once, so cycles end the walk
+    std::set<uint32_t>    seen  = {from};
+    std::vector<uint32_t> level = {from};
+    for (uint32_t current = 1; !level.empty(); ++current) {
+        if (depth && current > depth) {
+            for (auto pos : level) {
+                topology.truncated = topology.truncated || first[pos] != first[pos + 1];
+            }
+            break;
+        }
+
+        std::vector<uint32_t> next;
+        for (auto pos : level) {
+            for (uint32_t i = first[pos]; i < first[pos + 1]; ++i) {
+                const auto& link = graph.links[items[i]];
+                topology.links.push_back(link);
+
+                auto other = graph.pos.at(down ? link.destId : link.srcId);
+                if (seen.insert(other).second) {
+                    topology.devices.push_back({graph.devices[other], direction, current});
+                    next.push_back(other);
+                }
+            }
+        }
+        level = std::move(next);
+    }
+}
+
+bool PowerGraph::hasCycle(const std::vector<Link>& links)
+{
+    // devices are removed as long as nothing powers them, what is left is fed by a loop
+    std::map<uint32_t, uint32_t>              feeds;
+    std::map<uint32_t, std::vector<uint32_t>> powered;
+    for (const auto& link : links) {
+        ++feeds[link.destId];
+        feeds.emplace(link.srcId, 0);
+        powered[link.srcId].push_back(link.destId);
+    }
+
+    std::vector<uint32_t> free;
+    for (const auto& [id, count] : feeds) {
+        if (!count) {
+            free.push_back(id);
+        }
+    }
+
+    size_t removed = 0;
+    while (!free.empty()) {
+        auto id = free.back();
+        free.pop_back();
+        ++removed;
+        for (auto dest : powered[id]) {
+            if (!--feeds[dest]) {
+                free.push_back(dest);
+            }
+        }
+    }
+    return removed != feeds.size();
+}
+
+// =========================================================================================================================================
+
+PowerGraph::Topology PowerGraph::chain(uint32_t id, Direction direction, uint32_t depth)
+{
+    auto     current = graph();
+    Topology ret;
+
+    auto it = current->pos.find(id);
+    if (it == current->pos.end()) {
+        return ret;
+    }
+
+    ret.devices.push_back({current->devices[it->second], Direction::Both, 0});
+    if (direction != Direction::Downstream) {
+        walk(*current, ret, it->second, Direction::Upstream, depth);
+    }
+    if (direction != Direction::Upstream) {
+        walk(*current, ret, it->second, Direction::Downstream, depth);
+    }
+
+    // a link in a loop is seen from both sides
+    std::set<std::pair<uint32_t, uint32_t>> unique;
+    ret.links.erase(std::remove_if(ret.links.begin(), ret.links.end(),
+                        [&](const Link& link) {
+                            return !unique.emplace(link.srcId, link.destId).second;
+                        }),
+        ret.links.end());
+
+    ret.cycle = hasCycle(ret.links);
+    return ret;
+}
+
+PowerGraph::Topology PowerGraph::container(const std::vector<uint32_t>& ids)
+{
+    auto     current = graph();
+    Topology ret;
+
+    std::set<uint32_t> devices;
+    std::set<uint32_t> links;
+    for (auto id : ids) {
+        auto it = current->pos.find(id);
+        if (it == current->pos.end()) {
+            continue;
+        }
+        auto pos = it->second;
+        links.insert(current->out.begin() + current->outFirst[pos], current->out.begin() + current->outFirst[pos + 1]);
+        links.insert(current->in.begin() + current->inFirst[pos], current->in.begin() + current->inFirst[pos + 1]);
+    }
+
+    for (auto index : links) {
+        const auto& link = current->links[index];
+        ret.links.push_back(link);
+        for (auto end : {link.srcId, link.destId}) {
+            if (devices.insert(end).second) {
+                ret.devices.push_back({current->devices[current->pos.at(end)], Direction::Both, 0});
+            }
+        }
+    }
+
+    ret.cycle = hasCycle(ret.links);
+    return ret;
+}
+
+} // namespace fty::asset
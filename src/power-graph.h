@@ -0,0 +1,122 @@
+/*  ====================================================================================================================
+    power-graph.h - In-memory graph of the power links
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include "asset-events.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fty::db {
+class Connection;
+}
+
+namespace fty::asset {
+
+/// Power chain links between the devices, kept in memory.
+/// Any asset change through this library reloads the graph before the next use (one query for the links, one for the
+/// devices), changes done elsewhere (other agents) are picked up when the graph expires.
+class PowerGraph
+{
+public:
+    /// Lifetime of the whole graph
+    static constexpr std::chrono::seconds MaxAge{60};
+
+    enum class Direction
+    {
+        Upstream,
+        Downstream,
+        Both
+    };
+
+    struct Device
+    {
+        uint32_t    id        = 0;
+        std::string iname;
+        std::string name;
+        uint16_t    typeId    = 0;
+        uint16_t    subTypeId = 0;
+    };
+
+    struct Link
+    {
+        uint32_t    srcId  = 0;
+        uint32_t    destId = 0;
+        std::string srcSocket;
+        std::string destSocket;
+    };
+
+    struct Topology
+    {
+        struct Item
+        {
+            Device    device;
+            Direction direction = Direction::Both; // Both for the asset asked for
+            uint32_t  level     = 0;               // links between the asset asked for and this one
+        };
+
+        std::vector<Item> devices;
+        std::vector<Link> links;
+        bool              cycle     = false; // some of the devices power themselves
+        bool              truncated = false; // depth limit reached
+    };
+
+    static PowerGraph& instance();
+
+    /// Devices powering the asset and/or powered by it, up to depth links away (0 for all)
+    Topology chain(uint32_t id, Direction direction, uint32_t depth);
+
+    /// Links of the devices located in the container, including the ones to devices outside of it
+    Topology container(const std::vector<uint32_t>& ids);
+
+private:
+    struct Graph
+    {
+        std::vector<Device>                    devices;
+        std::unordered_map<uint32_t, uint32_t> pos;      // position of the device in devices
+        std::vector<Link>                      links;
+        std::vector<uint32_t>                  outFirst; // by position, first link in out, outFirst[pos + 1] is the end
+        std::vector<uint32_t>                  out;      // links fed by the device
+        std::vector<uint32_t>                  inFirst;  // by position, first link in in, inFirst[pos + 1] is the end
+        std::vector<uint32_t>                  in;       // links feeding the device
+    };
+    using GraphPtr = std::shared_ptr<const Graph>;
+
+    PowerGraph();
+    void     onEvent(const events::Event& event);
+    GraphPtr graph();
+
+    static Graph load(fty::db::Connection& conn);
+    static void  walk(const Graph& graph, Topology& topology, uint32_t from, Direction direction, uint32_t depth);
+    static bool  hasCycle(const std::vector<Link>& links);
+
+private:
+    std::mutex                            m_loadMutex;
+    std::mutex                            m_mutex;
+    GraphPtr                              m_graph;
+    bool                                  m_reset = true;
+    std::chrono::steady_clock::time_point m_loaded;
+};
+
+} // namespace fty::asset
@@ -0,0 +1,212 @@
+#include "power-topology.h"
+#include "batch-read.h"
+#include "containment-tree.h"
+#include "db-pool.h"
+#include "metrics.h"
+#include "power-graph.h"
+#include <asset/asset-db2.h>
+#include <asset/asset-helpers.h>
+#include <fty/rest/component.h>
+#include <fty_common_asset_types.h>
+#include <pack/node.h>
+#include <algorithm>
+
+namespace fty::asset {
+
+struct Topology : public pack::Node
+{
+    struct Device : public pack::Node
+    {
+        pack::String id        = FIELD("id");
+        pack::String name      = FIELD("name");
+        pack::String type      = FIELD("type");
+        pack::String subType   = FIELD("sub_type");
+        pack::String direction = FIELD("direction");
+        pack::UInt32 level     = FIELD("level");
+
+        using pack::Node::Node;
+        META(Device, id, name, type, subType, direction, level);
+    };
+
+    struct Link : public pack::Node
+    {
+        pack::String srcId      = FIELD("src_id");
+        pack::String srcSocket  = FIELD("src_socket");
+        pack::String destId     = FIELD("dest_id");
+        pack::String destSocket = FIELD("dest_socket");
+
+        using pack::Node::Node;
+        META(Link, srcId, srcSocket, destId, destSocket);
+    };
+
+    pack::ObjectList<Device> devices   = FIELD("devices");
+    pack::ObjectList<Link>   links     = FIELD("links");
+    pack::Bool               cycle     = FIELD("cycle");
+    pack::Bool               truncated = FIELD("truncated");
+
+    using pack::Node::Node;
+    META(Topology, devices, links, cycle, truncated);
+};
+
+// =========================================================================================================================================
+
+static const char* directionName(PowerGraph::Direction direction)
+{
+    switch (direction) {
+        case PowerGraph::Direction::Upstream:
+            return "upstream";
+        case PowerGraph::Direction::Downstream:
+            return "downstream";
+        case PowerGraph::Direction::Both:
+            break;
+    }
+    return "";
+}
+
+static constexpr uint32_t MaxDepth = 100;
+
+// Assets located in the container, read from the database. False if the container does not exist.
+static bool contained(const rest::User& user, uint32_t containerId, std::vector<uint32_t>& ids)
+{
+    DbPool::Lease        lease(DbPool::instance().readTarget(user.login()));
+    fty::db::Connection& conn = lease.connection();
+    if (batch::elements(conn, {containerId}).empty()) {
+        return false;
+    }
+
+    metrics::DbCall call;
+    auto            list = db::asset::select::itemsByContainer(
+        conn, containerId,
+        [&](const fty::db::Row& row) {
+            call.rows(1);
+            ids.push_back(row.get<uint32_t>("id"));
+        },
+        {}, {});
+    if (!list) {
+        throw std::runtime_error(list.error());
+    }
+    return true;
+}
+
+unsigned PowerTopology::run()
+{
+    static auto&     stats = metrics::endpoint("asset/power-topology");
+    metrics::Request measure(stats, m_reply);
+
+    metrics::Scope permissions(metrics::Phase::Permissions);
+    rest::User     user(m_request);
+    if (auto ret = checkPermissions(user.profile(), m_permissions); !ret) {
+        throw rest::Error(ret.error());
+    }
+    permissions.stop();
+
+    if (m_request.type() != rest::Request::Type::Get) {
+        throw rest::errors::MethodNotAllowed(m_request.typeStr());
+    }
+
+    auto id = m_request.queryArg<std::string>("id");
+    auto in = m_request.queryArg<std::string>("in");
+    if ((!id || id->empty()) && (!in || in->empty())) {
+        throw rest::errors::RequestParamRequired("id");
+    }
+    if (id && !id->empty() && in && !in->empty()) {
+        throw rest::errors::RequestParamBad("in", *in, "either id or in"_tr);
+    }
+
+    auto direction = PowerGraph::Direction::Both;
+    if (auto dir = m_request.queryArg<std::string>("direction"); dir && !dir->empty()) {
+        if (*dir == "upstream") {
+            direction = PowerGraph::Direction::Upstream;
+        } else if (*dir == "downstream") {
+            direction = PowerGraph::Direction::Downstream;
+        } else if (*dir != "both") {
+            throw rest::errors::RequestParamBad("direction", *dir, "upstream, downstream or both"_tr);
+        }
+    }
+
+    uint32_t depth = 0;
+    if (auto lim = m_request.queryArg<std::string>("depth")) {
+        // digits only: stoul() would accept a sign, spaces and trailing garbage
+        bool number = !lim->empty() && lim->size() <= 6 && std::all_of(lim->begin(), lim->end(), ::isdigit);
+        depth       = number ? uint32_t(std::stoul(*lim)) : 0;
+        if (!depth || depth > MaxDepth) {
+            throw rest::errors::RequestParamBad("depth", *lim, "number from 1 to {}"_tr.format(MaxDepth));
+        }
+    }
+
+    // the graph is only loaded on the first use, and reloaded after changes or when it expires
+    metrics::Scope       dbScope(metrics::Phase::Db);
+    PowerGraph::Topology topology;
+    if (id && !id->empty()) {
+        measure.param("id", *id);
+        auto assetId = checkElementIdentifier("id", *id);
+        if (!assetId) {
+            throw rest::errors::RequestParamBad("id", *id, "valid asset id"_tr);
+        }
+        try {
+            topology = PowerGraph::instance().chain(*assetId, direction, depth);
+        } catch (const std::exception& e) {
+            throw rest::errors::Internal(e.what());
+        }
+    } else {
+        measure.param("in", *in);
+        auto containerId = checkElementIdentifier("in", *in);
+        if (!containerId) {
+            throw rest::errors::RequestParamBad("in", *in, "valid container id"_tr);
+        }
+        std::vector<uint32_t> ids = {*containerId};
+        bool                  found = false;
+        try {
+            if (auto nodes = ContainmentTree::instance().descendants(*containerId, {})) {
+                found = true;
+                for (const auto& node : *nodes) {
+                    ids.push_back(node.id);
+                }
+            } else {
+                // not in the tree yet (created elsewhere and not announced), as list-in does
+                found = contained(user, *containerId, ids);
+            }
+            if (found) {
+                topology = PowerGraph::instance().container(ids);
+            }
+        } catch (const std::exception& e) {
+            throw rest::errors::Internal(e.what());
+        }
+        if (!found) {
+            throw rest::errors::ElementNotFound(*in);
+        }
+    }
+    dbScope.stop();
+
+    metrics::Scope serialization(metrics::Phase::Serialization);
+
+    Topology                        result;
+    std::map<uint32_t, std::string> inames;
+    for (const auto& item : topology.devices) {
+        auto& dev     = result.devices.append();
+        dev.id        = item.device.iname;
+        dev.name      = item.device.name;
+        dev.type      = persist::typeid_to_type(item.device.typeId);
+        dev.subType   = persist::subtypeid_to_subtype(item.device.subTypeId);
+        dev.direction = directionName(item.direction);
+        dev.level     = item.level;
+        inames.emplace(item.device.id, item.device.iname);
+    }
+    for (const auto& item : topology.links) {
+        auto& link      = result.links.append();
+        link.srcId      = inames[item.srcId];
+        link.srcSocket  = item.srcSocket;
+        link.destId     = inames[item.destId];
+        link.destSocket = item.destSocket;
+    }
+    result.cycle     = topology.cycle;
+    result.truncated = topology.truncated;
+
+    m_reply << *pack::json::serialize(result, pack::Option::WithDefaults);
+
+    return HTTP_OK;
+}
+
+} // namespace fty::asset
+
+registerHandler(fty::asset::PowerTopology)
@@ -0,0 +1,99 @@
+/*  ====================================================================================================================
+    rack-fit.cpp - Placement of devices sent in documents checked against the rack index
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "rack-fit.h"
+#include "batch-read.h"
+#include "rack-index.h"
+#include <algorithm>
+#include <asset/asset-cam.h>
+#include <cxxtools/serializationinfo.h>
+#include <fty/rest/translate.h>
+#include <fty_common_asset_types.h>
+
+namespace fty::asset::fit {
+
+static std::optional<uint32_t> unsignedValue(const ExtMap& ext, const std::string& key)
+{
+    auto it = ext.find(key);
+    if (it == ext.end()) {
+        return std::nullopt;
+    }
+
+    // digits only, units of a rack are few
+    const auto& text = it->second.first;
+    if (text.empty() || text.size() > 6 || !std::all_of(text.begin(), text.end(), ::isdigit)) {
+        return std::nullopt;
+    }
+    return uint32_t(std::stoul(text));
+}
+
+std::optional<Placement> requested(const cxxtools::SerializationInfo& si)
+{
+    Placement ret;
+    if (auto location = si.findMember("location")) {
+        *location >>= ret.rack;
+    }
+    if (ret.rack.empty()) {
+        return std::nullopt;
+    }
+
+    ExtMap ext;
+    getExtMapFromSi(si, ext);
+
+    auto size     = unsignedValue(ext, "u_size");
+    auto position = unsignedValue(ext, "location_u_pos");
+    if (!size || !position || !*size || !*position) {
+        return std::nullopt;
+    }
+    ret.size     = *size;
+    ret.position = *position;
+    return ret;
+}
+
+std::string check(fty::db::Connection& conn, const Placement& placement, const std::string& iname)
+{
+    // rack and asset in one read
+    std::vector<std::string> names = {placement.rack};
+    if (!iname.empty()) {
+        names.push_back(iname);
+    }
+    auto found = batch::named(conn, names);
+
+    auto rack = found.find(placement.rack);
+    if (rack == found.end() || rack->second.typeId != persist::type_to_typeid("rack")) {
+        return {};
+    }
+    uint32_t assetId = 0;
+    if (auto asset = found.find(iname); asset != found.end()) {
+        assetId = asset->second.id;
+    }
+
+    auto occupancy = RackIndex::instance().rack(rack->second.id);
+    if (!occupancy || !occupancy->size()) {
+        return {};
+    }
+    if (!occupancy->fits(placement.position, placement.size, assetId)) {
+        return "Asset does not fit in the rack at position {}"_tr.format(placement.position);
+    }
+    return {};
+}
+
+} // namespace fty::asset::fit
@@ -0,0 +1,53 @@
+/*  ====================================================================================================================
+    rack-fit.h - Placement of devices sent in documents checked against the rack index
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace cxxtools {
+class SerializationInfo;
+}
+
+namespace fty::db {
+class Connection;
+}
+
+namespace fty::asset::fit {
+
+/// Place of a device in a rack asked by a document: its location and its u_size and location_u_pos ext attributes
+struct Placement
+{
+    std::string rack;
+    uint32_t    position = 0;
+    uint32_t    size     = 0;
+};
+
+/// Placement asked by a create or edit document, nullopt if it does not place anything in units
+std::optional<Placement> requested(const cxxtools::SerializationInfo& si);
+
+/// Checks the placement of the asset (internal name, empty for a new one) against the rack index, which reads the
+/// database only for a rack it does not hold. Returns the reason why it does not fit, empty if it fits or if the
+/// location is not a rack known by its internal name: the import checks the placement again anyway.
+std::string check(fty::db::Connection& conn, const Placement& placement, const std::string& iname = {});
+
+} // namespace fty::asset::fit
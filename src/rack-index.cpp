@@ -0,0 +1,125 @@
+/*  ====================================================================================================================
+    rack-index.cpp - In-memory index of rack occupancy
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "rack-index.h"
+#include "db-pool.h"
+#include <fty_common_db_connection.h>
+
+namespace fty::asset {
+
+RackIndex& RackIndex::instance()
+{
+    static RackIndex index;
+    return index;
+}
+
+RackIndex::RackIndex()
+{
+    events::subscribe([this](const events::Event& event) {
+        onEvent(event);
+    });
+}
+
+RackIndex::RackPtr RackIndex::rack(uint32_t id)
+{
+    return racks({id})[id];
+}
+
+std::map<uint32_t, RackIndex::RackPtr> RackIndex::racks(const std::vector<uint32_t>& ids)
+{
+    std::map<uint32_t, RackPtr> ret;
+    std::vector<uint32_t>       missing;
+    uint64_t                    generation = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto                        now = std::chrono::steady_clock::now();
+        for (const auto& id : ids) {
+            if (auto it = m_racks.find(id); it != m_racks.end() && now - it->second.loaded < MaxAge) {
+                ret.emplace(id, it->second.rack);
+            } else {
+                missing.push_back(id);
+            }
+        }
+        generation = m_generation;
+    }
+
+    if (missing.empty()) {
+        return ret;
+    }
+
+    DbPool::Lease        lease;
+    fty::db::Connection& conn   = lease.connection();
+    auto                 loaded = RackOccupancy::load(conn, missing);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // something was changed while loading, result is good for this request but not for the index
+    bool keep = generation == m_generation;
+    auto now  = std::chrono::steady_clock::now();
+    for (auto& [id, occupancy] : loaded) {
+        auto rack = std::make_shared<const RackOccupancy>(std::move(occupancy));
+        ret.emplace(id, rack);
+        if (keep) {
+            drop(id);
+            m_racks[id] = {rack, now};
+            for (const auto& dev : rack->devices()) {
+                m_deviceRack[dev.id] = id;
+            }
+        }
+    }
+    return ret;
+}
+
+void RackIndex::drop(uint32_t rackId)
+{
+    if (auto it = m_racks.find(rackId); it != m_racks.end()) {
+        for (const auto& dev : it->second.rack->devices()) {
+            if (auto found = m_deviceRack.find(dev.id); found != m_deviceRack.end() && found->second == rackId) {
+                m_deviceRack.erase(found);
+            }
+        }
+        m_racks.erase(it);
+    }
+}
+
+void RackIndex::onEvent(const events::Event& event)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_generation;
+
+    // new asset somewhere unknown, a lot of them, or an asset known by its name only
+    if (event.type == events::Type::Reset || event.external || (event.type == events::Type::Created && !event.parentId)) {
+        m_racks.clear();
+        m_deviceRack.clear();
+        return;
+    }
+
+    // the rack itself, the rack it was placed in before and the one it is placed in now
+    if (auto it = m_deviceRack.find(event.id); it != m_deviceRack.end()) {
+        drop(it->second);
+    }
+    drop(event.id);
+    if (event.parentId) {
+        drop(event.parentId);
+    }
+}
+
+} // namespace fty::asset
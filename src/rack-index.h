@@ -0,0 +1,68 @@
+/*  ====================================================================================================================
+    rack-index.h - In-memory index of rack occupancy
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include "asset-events.h"
+#include "rack-occupancy.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+namespace fty::asset {
+
+/// Occupancy of racks kept in memory.
+/// A rack is loaded on first use and dropped when the rack or anything placed in it is changed through this library.
+/// Changes done elsewhere (other agents) are picked up when the entry expires.
+class RackIndex
+{
+public:
+    using RackPtr = std::shared_ptr<const RackOccupancy>;
+
+    /// Lifetime of a loaded rack
+    static constexpr std::chrono::seconds MaxAge{30};
+
+    static RackIndex& instance();
+
+    /// Occupancy of the rack
+    RackPtr rack(uint32_t id);
+
+    /// Occupancy of the racks, all the missing ones are loaded in one query
+    std::map<uint32_t, RackPtr> racks(const std::vector<uint32_t>& ids);
+
+private:
+    struct Entry
+    {
+        RackPtr                               rack;
+        std::chrono::steady_clock::time_point loaded;
+    };
+
+    RackIndex();
+    void onEvent(const events::Event& event);
+    void drop(uint32_t rackId);
+
+private:
+    std::mutex                   m_mutex;
+    std::map<uint32_t, Entry>    m_racks;
+    std::map<uint32_t, uint32_t> m_deviceRack;
+    uint64_t                     m_generation = 0;
+};
+
+} // namespace fty::asset
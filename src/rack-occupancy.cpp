@@ -0,0 +1,181 @@
+/*  ====================================================================================================================
+    rack-occupancy.cpp - Occupied units of racks
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "rack-occupancy.h"
+#include "metrics.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <fty_common_db_connection.h>
+
+namespace fty::asset {
+
+static uint32_t toUnits(const std::string& value)
+{
+    char* end = nullptr;
+    auto  ret = std::strtoul(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0') {
+        return 0;
+    }
+    return uint32_t(ret);
+}
+
+// =========================================================================================================================================
+
+RackOccupancy::RackOccupancy(uint32_t id, uint32_t size, std::vector<Device> devices)
+    : m_id(id)
+    , m_size(size)
+    , m_devices(std::move(devices))
+{
+    m_bitmap = bitmap(0);
+}
+
+uint32_t RackOccupancy::id() const
+{
+    return m_id;
+}
+
+uint32_t RackOccupancy::size() const
+{
+    return m_size;
+}
+
+const std::vector<RackOccupancy::Device>& RackOccupancy::devices() const
+{
+    return m_devices;
+}
+
+RackOccupancy::Bitmap RackOccupancy::bitmap(uint32_t ignoreId) const
+{
+    Bitmap bits((m_size + 63) / 64, 0);
+    for (const auto& dev : m_devices) {
+        if (ignoreId && dev.id == ignoreId) {
+            continue;
+        }
+        for (uint32_t unit = dev.position; unit < dev.position + dev.size && unit <= m_size; ++unit) {
+            if (unit > 0) {
+                bits[(unit - 1) / 64] |= uint64_t(1) << ((unit - 1) % 64);
+            }
+        }
+    }
+    return bits;
+}
+
+bool RackOccupancy::isSet(const Bitmap& bits, uint32_t unit) const
+{
+    return bits[(unit - 1) / 64] & (uint64_t(1) << ((unit - 1) % 64));
+}
+
+bool RackOccupancy::fits(uint32_t position, uint32_t usize, uint32_t ignoreId) const
+{
+    if (position == 0 || usize == 0 || position + usize - 1 > m_size) {
+        return false;
+    }
+
+    const Bitmap& bits = ignoreId ? bitmap(ignoreId) : m_bitmap;
+    for (uint32_t unit = position; unit < position + usize; ++unit) {
+        if (isSet(bits, unit)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<RackOccupancy::Range> RackOccupancy::freeRanges(uint32_t usize, uint32_t ignoreId) const
+{
+    std::vector<Range> ret;
+    if (usize == 0) {
+        return ret;
+    }
+
+    const Bitmap& bits = ignoreId ? bitmap(ignoreId) : m_bitmap;
+
+    uint32_t start = 0;
+    for (uint32_t unit = 1; unit <= m_size + 1; ++unit) {
+        bool busy = unit > m_size || isSet(bits, unit);
+        if (!busy && !start) {
+            start = unit;
+        } else if (busy && start) {
+            if (unit - start >= usize) {
+                ret.push_back({start, unit - start});
+            }
+            start = 0;
+        }
+    }
+    return ret;
+}
+
+std::map<uint32_t, RackOccupancy> RackOccupancy::load(fty::db::Connection& conn, const std::vector<uint32_t>& racks)
+{
+    std::map<uint32_t, RackOccupancy> ret;
+    if (racks.empty()) {
+        return ret;
+    }
+
+    std::string ids;
+    for (const auto& id : racks) {
+        ids += fmt::format("{}{}", ids.empty() ? "" : ", ", id);
+    }
+
+    // size of the racks and size/position of everything placed in them
+    // clang-format off
+    std::string sql = fmt::format(R"(
+        SELECT
+            e.id_asset_element AS id,
+            e.id_parent AS parentId,
+            COALESCE(MAX(CASE WHEN a.keytag = 'u_size' THEN a.value END), '') AS usize,
+            COALESCE(MAX(CASE WHEN a.keytag = 'location_u_pos' THEN a.value END), '') AS position
+        FROM t_bios_asset_element AS e
+        INNER JOIN t_bios_asset_ext_attributes AS a
+            ON a.id_asset_element = e.id_asset_element AND a.keytag IN ('u_size', 'location_u_pos')
+        WHERE e.id_asset_element IN ({0}) OR e.id_parent IN ({0})
+        GROUP BY e.id_asset_element, e.id_parent
+    )", ids);
+    // clang-format on
+
+    std::map<uint32_t, uint32_t>            sizes;
+    std::map<uint32_t, std::vector<Device>> devices;
+
+    metrics::DbCall call;
+    for (const auto& row : conn.prepare(sql).select()) {
+        call.rows(1);
+        uint32_t id = row.get<uint32_t>("id");
+        if (std::find(racks.begin(), racks.end(), id) != racks.end()) {
+            sizes[id] = toUnits(row.get("usize"));
+            continue;
+        }
+
+        Device dev;
+        dev.id       = id;
+        dev.size     = toUnits(row.get("usize"));
+        dev.position = toUnits(row.get("position"));
+        if (dev.size && dev.position) {
+            devices[row.get<uint32_t>("parentId")].push_back(dev);
+        }
+    }
+
+    for (const auto& id : racks) {
+        ret.emplace(id, RackOccupancy(id, sizes[id], std::move(devices[id])));
+    }
+    return ret;
+}
+
+} // namespace fty::asset
@@ -0,0 +1,81 @@
+/*  ====================================================================================================================
+    rack-occupancy.h - Occupied units of racks
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace fty::db {
+class Connection;
+}
+
+namespace fty::asset {
+
+/// Occupied units of one rack, units are numbered from 1 (bottom) to the rack size
+class RackOccupancy
+{
+public:
+    struct Range
+    {
+        uint32_t position = 0;
+        uint32_t size     = 0;
+    };
+
+    struct Device
+    {
+        uint32_t id       = 0;
+        uint32_t position = 0;
+        uint32_t size     = 0;
+    };
+
+public:
+    RackOccupancy() = default;
+    RackOccupancy(uint32_t id, uint32_t size, std::vector<Device> devices);
+
+    uint32_t                   id() const;
+    uint32_t                   size() const;
+    const std::vector<Device>& devices() const;
+
+    /// Checks if a device of `usize` units fits at `position`. Device `ignoreId` (the one being moved) is considered
+    /// as removed from the rack.
+    bool fits(uint32_t position, uint32_t usize, uint32_t ignoreId = 0) const;
+
+    /// All the free contiguous ranges at least `usize` units long
+    std::vector<Range> freeRanges(uint32_t usize, uint32_t ignoreId = 0) const;
+
+    /// Loads occupancy of given racks, all of them in one query
+    static std::map<uint32_t, RackOccupancy> load(fty::db::Connection& conn, const std::vector<uint32_t>& racks);
+
+private:
+    using Bitmap = std::vector<uint64_t>;
+
+    Bitmap bitmap(uint32_t ignoreId) const;
+    bool   isSet(const Bitmap& bits, uint32_t unit) const;
+
+private:
+    uint32_t            m_id   = 0;
+    uint32_t            m_size = 0;
+    std::vector<Device> m_devices;
+    Bitmap              m_bitmap;
+};
+
+} // namespace fty::asset
@@ -20,9 +20,11 @@
 */
 
 #include "read.h"
+#include "db-pool.h"
+#include "metrics.h"
 #include <asset/asset-helpers.h>
 #include <asset/json.h>
-#include <asset/asset-db.h>
+#include <asset/asset-db2.h>
 #include <fty/rest/audit-log.h>
 #include <fty/rest/component.h>
 #include <fty_common_asset_types.h>
@@ -31,15 +33,24 @@ namespace fty::asset {
 
 unsigned Read::run()
 {
-    rest::User user(m_request);
+    static auto&     stats = metrics::endpoint("asset/read");
+    metrics::Request measure(stats, m_reply);
+    // name lookup, asset document
+    measure.budget(2);
+
+    metrics::Scope permissions(metrics::Phase::Permissions);
+    rest::User     user(m_request);
     if (auto ret = checkPermissions(user.profile(), m_permissions); !ret) {
         throw rest::Error(ret.error());
     }
+    permissions.stop();
 
     auto strIdPrt = m_request.queryArg<std::string>("id");
     auto typePtr  = m_request.queryArg<std::string>("type");
     auto namePtr  = m_request.queryArg<std::string>("external_name");
 
+    metrics::Scope dbScope(metrics::Phase::Db);
+
     uint32_t id = 0;
     if (namePtr && !namePtr->empty()) {
         auto name = *namePtr;
@@ -47,7 +58,9 @@ unsigned Read::run()
             name = name.substr(1, name.length()-2);
         }
 
-        auto it = db::selectAssetElementByName(name, true);
+        DbPool::Lease   lease(DbPool::instance().readTarget(user.login()));
+        metrics::DbCall call;
+        auto            it = db::asset::selectAssetElementByName(lease.connection(), name, true);
         if (!it) {
             throw rest::errors::ElementNotFound(name);
         }
@@ -76,7 +89,14 @@ unsigned Read::run()
         }
     }
 
-    std::string jsonAsset = getJsonAsset(id);
+    measure.param("id", std::to_string(id));
+
+    std::string jsonAsset;
+    {
+        metrics::DbCall call;
+        jsonAsset = getJsonAsset(id);
+    }
+    dbScope.stop();
 
     if (jsonAsset.empty()) {
         throw rest::errors::Internal("get json asset failed."_tr);
@@ -0,0 +1,374 @@
+/*  ====================================================================================================================
+    request-body.cpp - Parsing of request bodies in place
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "request-body.h"
+#include <cctype>
+#include <fmt/format.h>
+#include <stdexcept>
+
+namespace fty::asset {
+
+BodyStream::Buffer::Buffer(std::string_view body)
+{
+    // the get area is only read from, streambuf just does not have a const interface
+    char* begin = const_cast<char*>(body.data());
+    setg(begin, begin, begin + body.size());
+}
+
+BodyStream::Buffer::pos_type BodyStream::Buffer::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    if (!(which & std::ios_base::in)) {
+        return pos_type(off_type(-1));
+    }
+
+    off_type base = dir == std::ios_base::beg ? 0 : dir == std::ios_base::cur ? gptr() - eback() : egptr() - eback();
+    off_type pos  = base + off;
+    if (pos < 0 || pos > egptr() - eback()) {
+        return pos_type(off_type(-1));
+    }
+    setg(eback(), eback() + pos, egptr());
+    return pos_type(pos);
+}
+
+BodyStream::Buffer::pos_type BodyStream::Buffer::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+BodyStream::BodyStream(std::string_view body)
+    : std::istream(nullptr)
+    , m_buffer(body)
+{
+    rdbuf(&m_buffer);
+}
+
+// =========================================================================================================================================
+
+JsonReader::JsonReader(std::string_view text)
+    : m_text(text)
+{
+}
+
+void JsonReader::error(const std::string& msg) const
+{
+    throw std::runtime_error(fmt::format("{} at offset {}", msg, m_pos));
+}
+
+char JsonReader::peek()
+{
+    while (m_pos < m_text.size() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\t' || m_text[m_pos] == '\n' || m_text[m_pos] == '\r')) {
+        ++m_pos;
+    }
+    return m_pos < m_text.size() ? m_text[m_pos] : '\0';
+}
+
+void JsonReader::expect(char ch)
+{
+    if (peek() != ch) {
+        error(fmt::format("expected '{}'", ch));
+    }
+    ++m_pos;
+}
+
+bool JsonReader::atArray()
+{
+    return peek() == '[';
+}
+
+bool JsonReader::atObject()
+{
+    return peek() == '{';
+}
+
+void JsonReader::enterArray()
+{
+    expect('[');
+    if (m_first.size() >= MaxDepth) {
+        error("document nested too deeply");
+    }
+    m_first.push_back(true);
+}
+
+void JsonReader::enterObject()
+{
+    expect('{');
+    if (m_first.size() >= MaxDepth) {
+        error("document nested too deeply");
+    }
+    m_first.push_back(true);
+}
+
+bool JsonReader::nextItem()
+{
+    if (m_first.empty()) {
+        error("not in an array");
+    }
+    if (peek() == ']') {
+        ++m_pos;
+        m_first.pop_back();
+        return false;
+    }
+    if (!m_first.back()) {
+        expect(',');
+    }
+    m_first.back() = false;
+    return true;
+}
+
+bool JsonReader::nextMember(std::string& key)
+{
+    if (m_first.empty()) {
+        error("not in an object");
+    }
+    if (peek() == '}') {
+        ++m_pos;
+        m_first.pop_back();
+        return false;
+    }
+    if (!m_first.back()) {
+        expect(',');
+    }
+    m_first.back() = false;
+    if (peek() != '"') {
+        error("expected member name");
+    }
+    key = string();
+    expect(':');
+    return true;
+}
+
+std::string JsonReader::scalar()
+{
+    switch (peek()) {
+        case '"':
+            return string();
+        case '{':
+        case '[':
+            error("expected a value, not an object or array");
+        default:
+            return literal();
+    }
+}
+
+void JsonReader::skip()
+{
+    if (atArray()) {
+        enterArray();
+        while (nextItem()) {
+            skip();
+        }
+    } else if (atObject()) {
+        enterObject();
+        std::string key;
+        while (nextMember(key)) {
+            skip();
+        }
+    } else {
+        scalar();
+    }
+}
+
+void JsonReader::finish()
+{
+    if (peek() != '\0' || m_pos != m_text.size()) {
+        error("unexpected content after the document");
+    }
+}
+
+// numbers, true, false and null
+// JSON number grammar: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+static bool isNumber(std::string_view value)
+{
+    size_t pos    = 0;
+    auto   digits = [&]() {
+        size_t start = pos;
+        while (pos < value.size() && std::isdigit(static_cast<unsigned char>(value[pos]))) {
+            ++pos;
+        }
+        return pos > start;
+    };
+
+    if (pos < value.size() && value[pos] == '-') {
+        ++pos;
+    }
+    if (pos < value.size() && value[pos] == '0') {
+        ++pos;
+    } else if (!digits()) {
+        return false;
+    }
+    if (pos < value.size() && value[pos] == '.') {
+        ++pos;
+        if (!digits()) {
+            return false;
+        }
+    }
+    if (pos < value.size() && (value[pos] == 'e' || value[pos] == 'E')) {
+        ++pos;
+        if (pos < value.size() && (value[pos] == '+' || value[pos] == '-')) {
+            ++pos;
+        }
+        if (!digits()) {
+            return false;
+        }
+    }
+    return pos == value.size();
+}
+
+std::string JsonReader::literal()
+{
+    size_t start = m_pos;
+    while (m_pos < m_text.size() && (std::isalnum(static_cast<unsigned char>(m_text[m_pos])) || m_text[m_pos] == '-' ||
+                                        m_text[m_pos] == '+' || m_text[m_pos] == '.')) {
+        ++m_pos;
+    }
+
+    auto value = m_text.substr(start, m_pos - start);
+    if (value == "null") {
+        return {};
+    }
+    if (value == "true" || value == "false") {
+        return std::string(value);
+    }
+    if (value.empty() || !(value[0] == '-' || std::isdigit(static_cast<unsigned char>(value[0])))) {
+        m_pos = start;
+        error("expected a value");
+    }
+    if (!isNumber(value)) {
+        m_pos = start;
+        error("malformed number");
+    }
+    return std::string(value);
+}
+
+static void appendUtf8(std::string& out, uint32_t code)
+{
+    if (code < 0x80) {
+        out += char(code);
+    } else if (code < 0x800) {
+        out += char(0xc0 | (code >> 6));
+        out += char(0x80 | (code & 0x3f));
+    } else if (code < 0x10000) {
+        out += char(0xe0 | (code >> 12));
+        out += char(0x80 | ((code >> 6) & 0x3f));
+        out += char(0x80 | (code & 0x3f));
+    } else {
+        out += char(0xf0 | (code >> 18));
+        out += char(0x80 | ((code >> 12) & 0x3f));
+        out += char(0x80 | ((code >> 6) & 0x3f));
+        out += char(0x80 | (code & 0x3f));
+    }
+}
+
+std::string JsonReader::string()
+{
+    expect('"');
+
+    auto hex4 = [&]() {
+        if (m_pos + 4 > m_text.size()) {
+            error("truncated escape sequence");
+        }
+        uint32_t code = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            char ch = m_text[m_pos++];
+            code <<= 4;
+            if (ch >= '0' && ch <= '9') {
+                code |= uint32_t(ch - '0');
+            } else if (ch >= 'a' && ch <= 'f') {
+                code |= uint32_t(ch - 'a' + 10);
+            } else if (ch >= 'A' && ch <= 'F') {
+                code |= uint32_t(ch - 'A' + 10);
+            } else {
+                error("bad escape sequence");
+            }
+        }
+        return code;
+    };
+
+    std::string ret;
+    while (true) {
+        // copy the plain run at once
+        size_t start = m_pos;
+        while (m_pos < m_text.size() && m_text[m_pos] != '"' && m_text[m_pos] != '\\' &&
+               static_cast<unsigned char>(m_text[m_pos]) >= 0x20) {
+            ++m_pos;
+        }
+        ret.append(m_text.data() + start, m_pos - start);
+
+        if (m_pos >= m_text.size()) {
+            error("unterminated string");
+        }
+        if (static_cast<unsigned char>(m_text[m_pos]) < 0x20) {
+            error("control character in string");
+        }
+        if (m_text[m_pos++] == '"') {
+            return ret;
+        }
+        if (m_pos >= m_text.size()) {
+            error("unterminated string");
+        }
+
+        switch (char ch = m_text[m_pos++]) {
+            case '"':
+            case '\\':
+            case '/':
+                ret += ch;
+                break;
+            case 'b':
+                ret += '\b';
+                break;
+            case 'f':
+                ret += '\f';
+                break;
+            case 'n':
+                ret += '\n';
+                break;
+            case 'r':
+                ret += '\r';
+                break;
+            case 't':
+                ret += '\t';
+                break;
+            case 'u': {
+                uint32_t code = hex4();
+                // surrogate pair, a lone half is not a character
+                if (code >= 0xd800 && code < 0xdc00) {
+                    if (m_text.substr(m_pos, 2) != "\\u") {
+                        error("bad surrogate pair");
+                    }
+                    m_pos += 2;
+                    uint32_t low = hex4();
+                    if (low < 0xdc00 || low >= 0xe000) {
+                        error("bad surrogate pair");
+                    }
+                    code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                } else if (code >= 0xdc00 && code < 0xe000) {
+                    error("bad surrogate pair");
+                }
+                appendUtf8(ret, code);
+                break;
+            }
+            default:
+                error("bad escape sequence");
+        }
+    }
+}
+
+} // namespace fty::asset
@@ -0,0 +1,99 @@
+/*  ====================================================================================================================
+    request-body.h - Parsing of request bodies in place
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fty::asset {
+
+/// Input stream reading the request body in place, instead of copying it into a stringstream.
+/// The body must outlive the stream.
+class BodyStream : public std::istream
+{
+public:
+    explicit BodyStream(std::string_view body);
+
+private:
+    class Buffer : public std::streambuf
+    {
+    public:
+        explicit Buffer(std::string_view body);
+
+    protected:
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+    };
+
+    Buffer m_buffer;
+};
+
+/// Pull parser of JSON documents, reading values straight into the caller's structures without building a tree.
+/// Errors (malformed document, unexpected value, too deep nesting) are thrown as std::runtime_error.
+class JsonReader
+{
+public:
+    /// Arrays and objects open at once, deeper documents are rejected
+    static constexpr size_t MaxDepth = 64;
+
+    explicit JsonReader(std::string_view text);
+
+    /// Enters the array, the items are iterated with nextItem()
+    void enterArray();
+
+    /// True when the current array has one more item, positioned on it
+    bool nextItem();
+
+    /// Enters the object, the members are iterated with nextMember()
+    void enterObject();
+
+    /// True when the current object has one more member, its value is read next
+    bool nextMember(std::string& key);
+
+    /// String, number or boolean value as text, empty for null
+    std::string scalar();
+
+    /// Skips the next value, whatever it is
+    void skip();
+
+    /// Checks that nothing but whitespace is left
+    void finish();
+
+    bool atArray();
+    bool atObject();
+
+private:
+    char              peek();
+    void              expect(char ch);
+    std::string       string();
+    std::string       literal();
+    [[noreturn]] void error(const std::string& msg) const;
+
+private:
+    std::string_view  m_text;
+    size_t            m_pos = 0;
+    std::vector<bool> m_first; // no item read yet, per open array or object
+};
+
+} // namespace fty::asset
@@ -0,0 +1,160 @@
+/*  ====================================================================================================================
+    response-cache.cpp - Replies of the listings kept until assets change
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "response-cache.h"
+#include "config.h"
+#include "metrics.h"
+#include <optional>
+
+namespace fty::asset {
+
+static constexpr unsigned StatusOk = 200;
+
+ResponseCache& ResponseCache::instance()
+{
+    static ResponseCache inst;
+    return inst;
+}
+
+ResponseCache::ResponseCache()
+{
+    events::subscribe([this](const events::Event& event) {
+        onEvent(event);
+    });
+}
+
+ResponseCache::ReplyPtr ResponseCache::run(
+    const std::string& key, const std::function<SingleFlight::Reply()>& func, DbPool::Target target)
+{
+    if (auto reply = get(key)) {
+        metrics::cached(true);
+        return reply;
+    }
+    metrics::cached(false);
+
+    // only the call computing the reply knows which generation it comes from, the ones sharing it leave it alone
+    std::optional<uint64_t> generation;
+    Clock::time_point       started;
+    auto reply = SingleFlight::instance().run(key, [&]() {
+        generation = this->generation();
+        started    = Clock::now();
+        return func();
+    });
+
+    // the replica may not have the last change yet, for as long as the clients which made it read from the primary
+    if (generation && target == DbPool::Target::Replica) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (started - m_changed < config::readAfterWrite()) {
+            generation.reset();
+        }
+    }
+
+    if (generation && reply->status == StatusOk) {
+        put(key, *generation, reply);
+    }
+    return reply;
+}
+
+ResponseCache::ReplyPtr ResponseCache::get(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+        return nullptr;
+    }
+
+    auto entry = it->second;
+    if (Clock::now() - entry->stored >= config::cacheTtl()) {
+        m_size -= entry->cost;
+        m_entries.erase(entry);
+        m_index.erase(it);
+        return nullptr;
+    }
+
+    m_entries.splice(m_entries.begin(), m_entries, entry);
+    return entry->reply;
+}
+
+void ResponseCache::put(const std::string& key, uint64_t generation, const ReplyPtr& reply)
+{
+    size_t limit = config::cacheSize();
+    size_t bytes = cost(key, *reply);
+    // one reply would push out too many others
+    if (bytes > limit / 4) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (generation != m_generation) {
+        return;
+    }
+
+    if (auto it = m_index.find(key); it != m_index.end()) {
+        m_size -= it->second->cost;
+        m_entries.erase(it->second);
+        m_index.erase(it);
+    }
+
+    m_entries.push_front({key, reply, bytes, Clock::now()});
+    m_index.emplace(key, m_entries.begin());
+    m_size += bytes;
+
+    while (m_size > limit) {
+        auto& last = m_entries.back();
+        m_size -= last.cost;
+        m_index.erase(last.key);
+        m_entries.pop_back();
+    }
+}
+
+uint64_t ResponseCache::generation() const
+{
+    return m_generation;
+}
+
+size_t ResponseCache::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_size;
+}
+
+void ResponseCache::onEvent(const events::Event&)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_generation;
+    m_changed = Clock::now();
+    m_entries.clear();
+    m_index.clear();
+    m_size = 0;
+}
+
+size_t ResponseCache::cost(const std::string& key, const SingleFlight::Reply& reply)
+{
+    // key is stored twice (entry and index), plus a rough overhead of the nodes
+    size_t ret = 2 * key.size() + reply.contentType.size() + reply.body.size() + 128;
+    for (const auto& [name, value] : reply.headers) {
+        ret += name.size() + value.size();
+    }
+    return ret;
+}
+
+} // namespace fty::asset
@@ -0,0 +1,93 @@
+/*  ====================================================================================================================
+    response-cache.h - Replies of the listings kept until assets change
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include "asset-events.h"
+#include "db-pool.h"
+#include "single-flight.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace fty::asset {
+
+/// Successful replies of the listings, served again without touching the database until an asset is changed.
+/// Every change published by the handlers moves the cache to a new generation and drops all the replies: listings
+/// depend on whole subtrees, so telling which ones a change affects is not worth it. Changes made outside of this
+/// library are not published, replies are also dropped after a while.
+/// Replies read from the replica right after a change may miss it, they are not kept until the replica caught up.
+/// Memory is bounded, the least recently used replies are evicted first.
+class ResponseCache
+{
+public:
+    using ReplyPtr = SingleFlight::ReplyPtr;
+
+    static ResponseCache& instance();
+
+    /// Cached reply of key, or the reply of func (coalesced with identical calls running at the same time).
+    /// Only replies with status 200 are kept. The key must hold everything the reply depends on, target is the database
+    /// func reads from.
+    ReplyPtr run(
+        const std::string& key, const std::function<SingleFlight::Reply()>& func, DbPool::Target target = DbPool::Target::Primary);
+
+    /// Cached reply of key, null if there is none
+    ReplyPtr get(const std::string& key);
+
+    /// Keeps the reply, unless assets were changed since generation (it may be computed from the old ones)
+    void put(const std::string& key, uint64_t generation, const ReplyPtr& reply);
+
+    /// Current state of the assets, read before computing a reply to put
+    uint64_t generation() const;
+
+    /// Memory used by the replies, in bytes
+    size_t size() const;
+
+private:
+    ResponseCache();
+    void onEvent(const events::Event& event);
+
+    static size_t cost(const std::string& key, const SingleFlight::Reply& reply);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry
+    {
+        std::string       key;
+        ReplyPtr          reply;
+        size_t            cost = 0;
+        Clock::time_point stored;
+    };
+    using Entries = std::list<Entry>;
+
+    mutable std::mutex                                 m_mutex;
+    std::atomic<uint64_t>                              m_generation{0};
+    Entries                                            m_entries; // most recently used first
+    std::unordered_map<std::string, Entries::iterator> m_index;
+    size_t                                             m_size = 0;
+    Clock::time_point                                  m_changed; // last change published
+};
+
+} // namespace fty::asset
@@ -0,0 +1,439 @@
+/*  ====================================================================================================================
+    search-index.cpp - In-memory full text index of assets
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "search-index.h"
+#include "batch-read.h"
+#include "db-pool.h"
+#include "message-bus.h"
+#include "metrics.h"
+#include <algorithm>
+#include <fty_common_asset_types.h>
+#include <fty_common_db_connection.h>
+#include <map>
+
+namespace fty::asset {
+
+// Attributes searched besides the names, exact keys and prefixes
+static const std::vector<std::string> SearchedKeys     = {"serial_no", "model", "manufacturer", "description", "asset_tag"};
+static const std::vector<std::string> SearchedPrefixes = {"ip.", "hostname.", "fqdn."};
+
+// Above this number of changed assets the whole index is reloaded
+static constexpr size_t MaxPartialLoad = 1000;
+
+static std::string lowered(const std::string& str)
+{
+    std::string ret(str);
+    std::transform(ret.begin(), ret.end(), ret.begin(), [](unsigned char ch) {
+        return char(std::tolower(ch));
+    });
+    return ret;
+}
+
+static uint32_t trigram(const std::string& str, size_t pos)
+{
+    return uint32_t(uint8_t(str[pos])) << 16 | uint32_t(uint8_t(str[pos + 1])) << 8 | uint32_t(uint8_t(str[pos + 2]));
+}
+
+static bool searched(const std::string& key)
+{
+    if (std::find(SearchedKeys.begin(), SearchedKeys.end(), key) != SearchedKeys.end()) {
+        return true;
+    }
+    return std::any_of(SearchedPrefixes.begin(), SearchedPrefixes.end(), [&](const std::string& prefix) {
+        return key.compare(0, prefix.size(), prefix) == 0;
+    });
+}
+
+// =========================================================================================================================================
+
+SearchIndex& SearchIndex::instance()
+{
+    static SearchIndex index;
+    return index;
+}
+
+SearchIndex::SearchIndex()
+{
+    events::subscribe([this](const events::Event& event) {
+        onEvent(event);
+    });
+    watchAssetStreams();
+}
+
+void SearchIndex::onEvent(const events::Event& event)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (event.external) {
+        m_dirtyNames.insert(event.name);
+    } else if (event.type == events::Type::Reset || !event.id) {
+        m_reset = true;
+    } else {
+        m_dirty.insert(event.id);
+    }
+}
+
+// Document of an asset, without its attributes
+static SearchIndex::Doc document(
+    uint32_t id, const std::string& iname, uint16_t typeId, uint16_t subTypeId, const std::string& assetTag)
+{
+    SearchIndex::Doc doc;
+    doc.id      = id;
+    doc.iname   = iname;
+    doc.type    = persist::typeid_to_type(typeId);
+    doc.subType = persist::subtypeid_to_subtype(subTypeId);
+    if (doc.subType == "N_A") {
+        doc.subType.clear();
+    }
+    doc.fields.push_back({"id", doc.iname, lowered(doc.iname)});
+    if (!assetTag.empty()) {
+        doc.fields.push_back({"asset_tag", assetTag, lowered(assetTag)});
+    }
+    return doc;
+}
+
+static void addAttribute(SearchIndex::Doc& doc, const std::string& key, const std::string& value)
+{
+    if (value.empty() || (key != "name" && !searched(key))) {
+        return;
+    }
+    // external name goes right after the internal one
+    auto pos = key == "name" ? doc.fields.begin() + 1 : doc.fields.end();
+    doc.fields.insert(pos, {key, value, lowered(value)});
+}
+
+std::vector<SearchIndex::Doc> SearchIndex::load(fty::db::Connection& conn, const std::vector<uint32_t>& ids)
+{
+    std::map<uint32_t, Doc> docs;
+
+    if (!ids.empty()) {
+        // changed assets, with the statements of the batch reads
+        for (const auto& [id, element] : batch::elements(conn, ids)) {
+            docs.emplace(id, document(id, element.name, element.typeId, element.subTypeId, element.assetTag));
+        }
+        for (const auto& [id, attributes] : batch::attributes(conn, ids)) {
+            if (auto it = docs.find(id); it != docs.end()) {
+                for (const auto& [key, attribute] : attributes) {
+                    addAttribute(it->second, key, attribute.value);
+                }
+            }
+        }
+    } else {
+        // clang-format off
+        static const std::string elementsSql = R"(
+            SELECT id_asset_element AS id, name, id_type AS typeId, id_subtype AS subTypeId, COALESCE(asset_tag, '') AS assetTag
+            FROM t_bios_asset_element
+        )";
+
+        static const std::string attributesSql = R"(
+            SELECT id_asset_element AS id, keytag, value
+            FROM t_bios_asset_ext_attributes
+            WHERE keytag IN ('name', 'serial_no', 'model', 'manufacturer', 'description')
+                OR keytag LIKE 'ip.%' OR keytag LIKE 'hostname.%' OR keytag LIKE 'fqdn.%'
+        )";
+        // clang-format on
+
+        {
+            metrics::DbCall call;
+            for (const auto& row : prepareCached(conn, elementsSql).select()) {
+                call.rows(1);
+                auto id = row.get<uint32_t>("id");
+                docs.emplace(id,
+                    document(id, row.get("name"), row.get<uint16_t>("typeId"), row.get<uint16_t>("subTypeId"), row.get("assetTag")));
+            }
+        }
+
+        metrics::DbCall call;
+        for (const auto& row : prepareCached(conn, attributesSql).select()) {
+            call.rows(1);
+            if (auto it = docs.find(row.get<uint32_t>("id")); it != docs.end()) {
+                addAttribute(it->second, row.get("keytag"), row.get("value"));
+            }
+        }
+    }
+
+    std::vector<Doc> ret;
+    ret.reserve(docs.size());
+    for (auto& [id, doc] : docs) {
+        ret.push_back(std::move(doc));
+    }
+    return ret;
+}
+
+// =========================================================================================================================================
+
+void SearchIndex::refresh()
+{
+    std::vector<uint32_t>    dirty;
+    std::vector<std::string> unknown;
+    bool                     full = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        unknown = resolveNames();
+
+        auto now = std::chrono::steady_clock::now();
+        full     = m_reset || now - m_loaded > MaxAge || m_dirty.size() + unknown.size() > MaxPartialLoad;
+        if (full) {
+            m_reset  = false;
+            m_loaded = now;
+        } else {
+            dirty.assign(m_dirty.begin(), m_dirty.end());
+        }
+        m_dirty.clear();
+    }
+
+    if (!full && dirty.empty() && unknown.empty()) {
+        return;
+    }
+
+    // changes announced while loading stay dirty for the next search
+    std::vector<Doc> docs;
+    try {
+        // the whole index from the replica, if any. Changes just made through this library may not be there yet,
+        // they are read from the primary database.
+        DbPool::Lease        lease(full ? DbPool::Target::Replica : DbPool::Target::Primary);
+        fty::db::Connection& conn = lease.connection();
+        if (full) {
+            docs = load(conn);
+        } else {
+            // names announced on the streams and not indexed yet: new assets, or the echo of one created here
+            for (const auto& [name, id] : batch::ids(conn, unknown)) {
+                if (std::find(dirty.begin(), dirty.end(), id) == dirty.end()) {
+                    dirty.push_back(id);
+                }
+            }
+            docs = load(conn, dirty);
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (full) {
+            m_reset = true;
+        } else {
+            m_dirty.insert(dirty.begin(), dirty.end());
+            m_dirtyNames.insert(unknown.begin(), unknown.end());
+        }
+        throw;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (full) {
+        m_docs.clear();
+        m_byId.clear();
+        m_trigrams.clear();
+        m_dead = 0;
+    } else {
+        for (const auto& id : dirty) {
+            remove(id);
+        }
+    }
+    for (auto& doc : docs) {
+        add(std::move(doc));
+    }
+    compact();
+}
+
+std::vector<std::string> SearchIndex::resolveNames()
+{
+    std::vector<std::string> unknown;
+    if (m_dirtyNames.empty()) {
+        return unknown;
+    }
+
+    std::set<std::string> found;
+    for (const auto& doc : m_docs) {
+        if (doc.alive && m_dirtyNames.count(doc.iname)) {
+            m_dirty.insert(doc.id);
+            found.insert(doc.iname);
+        }
+    }
+    // the others are looked up by name with the changed assets
+    for (const auto& name : m_dirtyNames) {
+        if (!found.count(name)) {
+            unknown.push_back(name);
+        }
+    }
+    m_dirtyNames.clear();
+    return unknown;
+}
+
+void SearchIndex::add(Doc&& doc)
+{
+    remove(doc.id);
+    m_byId[doc.id] = m_docs.size();
+    m_docs.push_back(std::move(doc));
+    index(uint32_t(m_docs.size() - 1));
+}
+
+void SearchIndex::index(uint32_t pos)
+{
+    for (const auto& field : m_docs[pos].fields) {
+        for (size_t i = 0; i + 3 <= field.lower.size(); ++i) {
+            auto& postings = m_trigrams[trigram(field.lower, i)];
+            if (postings.empty() || postings.back() != pos) {
+                postings.push_back(pos);
+            }
+        }
+    }
+}
+
+void SearchIndex::remove(uint32_t id)
+{
+    if (auto it = m_byId.find(id); it != m_byId.end()) {
+        m_docs[it->second].alive = false;
+        m_byId.erase(it);
+        ++m_dead;
+    }
+}
+
+void SearchIndex::compact()
+{
+    if (m_dead < 1000 || m_dead * 2 < m_docs.size()) {
+        return;
+    }
+
+    std::vector<Doc> docs;
+    docs.reserve(m_docs.size() - m_dead);
+    for (auto& doc : m_docs) {
+        if (doc.alive) {
+            docs.push_back(std::move(doc));
+        }
+    }
+
+    m_docs = std::move(docs);
+    m_byId.clear();
+    m_trigrams.clear();
+    m_dead = 0;
+    for (uint32_t pos = 0; pos < m_docs.size(); ++pos) {
+        m_byId[m_docs[pos].id] = pos;
+        index(pos);
+    }
+}
+
+// =========================================================================================================================================
+
+std::vector<SearchIndex::Hit> SearchIndex::search(const std::string& text, size_t limit, const std::string& type)
+{
+    {
+        // one load at a time, other searches wait for it instead of using an outdated index
+        std::lock_guard<std::mutex> load(m_loadMutex);
+        refresh();
+    }
+
+    std::string needle = lowered(text);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // documents having all the trigrams of the text, all of them for short texts
+    std::vector<uint32_t> candidates;
+    if (needle.size() >= 3) {
+        std::vector<const std::vector<uint32_t>*> lists;
+        for (size_t i = 0; i + 3 <= needle.size(); ++i) {
+            auto it = m_trigrams.find(trigram(needle, i));
+            if (it == m_trigrams.end()) {
+                return {};
+            }
+            lists.push_back(&it->second);
+        }
+        std::sort(lists.begin(), lists.end(), [](const auto* l, const auto* r) {
+            return l->size() < r->size();
+        });
+
+        candidates = *lists.front();
+        for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+            std::vector<uint32_t> next;
+            std::set_intersection(
+                candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(), std::back_inserter(next));
+            candidates = std::move(next);
+        }
+    } else {
+        candidates.resize(m_docs.size());
+        for (uint32_t pos = 0; pos < m_docs.size(); ++pos) {
+            candidates[pos] = pos;
+        }
+    }
+
+    // names weigh more than other attributes, exact matches more than prefixes, prefixes more than the rest
+    std::vector<std::pair<uint32_t, const Field*>> scored;
+    std::vector<uint32_t>                          scores;
+    for (auto pos : candidates) {
+        const auto& doc = m_docs[pos];
+        if (!doc.alive || (!type.empty() && doc.type != type)) {
+            continue;
+        }
+
+        uint32_t     best      = 0;
+        const Field* bestField = nullptr;
+        for (size_t i = 0; i < doc.fields.size(); ++i) {
+            const auto& field = doc.fields[i];
+            auto        found = field.lower.find(needle);
+            if (found == std::string::npos) {
+                continue;
+            }
+            uint32_t score = field.lower.size() == needle.size() ? 100 : (found == 0 ? 60 : 30);
+            if (field.key == "id" || field.key == "name") {
+                score += 20;
+            }
+            if (score > best) {
+                best      = score;
+                bestField = &field;
+            }
+        }
+        if (bestField) {
+            scored.emplace_back(pos, bestField);
+            scores.push_back(best);
+        }
+    }
+
+    std::vector<size_t> order(scored.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    auto byScore = [&](size_t l, size_t r) {
+        if (scores[l] != scores[r]) {
+            return scores[l] > scores[r];
+        }
+        return m_docs[scored[l].first].iname < m_docs[scored[r].first].iname;
+    };
+    if (order.size() > limit) {
+        std::partial_sort(order.begin(), order.begin() + long(limit), order.end(), byScore);
+        order.resize(limit);
+    } else {
+        std::sort(order.begin(), order.end(), byScore);
+    }
+
+    std::vector<Hit> ret;
+    ret.reserve(order.size());
+    for (auto idx : order) {
+        const auto& doc = m_docs[scored[idx].first];
+        Hit         hit;
+        hit.id      = doc.id;
+        hit.iname   = doc.iname;
+        hit.name    = doc.fields.size() > 1 && doc.fields[1].key == "name" ? doc.fields[1].value : doc.iname;
+        hit.type    = doc.type;
+        hit.subType = doc.subType;
+        hit.field   = scored[idx].second->key;
+        hit.value   = scored[idx].second->value;
+        hit.score   = scores[idx];
+        ret.push_back(std::move(hit));
+    }
+    return ret;
+}
+
+} // namespace fty::asset
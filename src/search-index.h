@@ -0,0 +1,108 @@
+/*  ====================================================================================================================
+    search-index.h - In-memory full text index of assets
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include "asset-events.h"
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fty::db {
+class Connection;
+}
+
+namespace fty::asset {
+
+/// Trigram index over the names and the main attributes of the assets.
+/// Built on first use, changed assets are reloaded before the next search: the ones changed through this library and
+/// the ones announced on the asset streams. The index also expires, for changes missed while the streams were not
+/// watched.
+class SearchIndex
+{
+public:
+    /// Lifetime of the whole index
+    static constexpr std::chrono::minutes MaxAge{2};
+
+    struct Hit
+    {
+        uint32_t    id = 0;
+        std::string iname;
+        std::string name;
+        std::string type;
+        std::string subType;
+        std::string field; // attribute which matched best
+        std::string value;
+        uint32_t    score = 0;
+    };
+
+    static SearchIndex& instance();
+
+    /// Assets matching the text (case insensitive), best first
+    std::vector<Hit> search(const std::string& text, size_t limit, const std::string& type = {});
+
+public:
+    struct Field
+    {
+        std::string key;
+        std::string value;
+        std::string lower;
+    };
+
+    struct Doc
+    {
+        uint32_t           id = 0;
+        std::string        iname;
+        std::string        type;
+        std::string        subType;
+        std::vector<Field> fields; // iname and external name first
+        bool               alive = true;
+    };
+
+    /// Documents of the assets, all of them or the listed ones
+    static std::vector<Doc> load(fty::db::Connection& conn, const std::vector<uint32_t>& ids = {});
+
+private:
+    SearchIndex();
+    void onEvent(const events::Event& event);
+    std::vector<std::string> resolveNames();
+    void refresh();
+    void add(Doc&& doc);
+    void index(uint32_t pos);
+    void remove(uint32_t id);
+    void compact();
+
+private:
+    std::mutex                                          m_loadMutex;
+    std::mutex                                          m_mutex;
+    std::vector<Doc>                                    m_docs;
+    std::unordered_map<uint32_t, size_t>                m_byId;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> m_trigrams;
+    size_t                                              m_dead = 0;
+    std::set<uint32_t>                                  m_dirty;
+    std::set<std::string>                               m_dirtyNames; // changes announced on the asset streams
+    bool                                                m_reset = true;
+    std::chrono::steady_clock::time_point               m_loaded;
+};
+
+} // namespace fty::asset
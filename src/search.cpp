@@ -0,0 +1,99 @@
+#include "search.h"
+#include "metrics.h"
+#include "search-index.h"
+#include <algorithm>
+#include <fty/rest/component.h>
+#include <fty_common_asset_types.h>
+#include <pack/node.h>
+
+namespace fty::asset {
+
+struct SearchHit : public pack::Node
+{
+    pack::String id      = FIELD("id");
+    pack::String name    = FIELD("name");
+    pack::String type    = FIELD("type");
+    pack::String subType = FIELD("sub_type");
+    pack::String field   = FIELD("match");
+    pack::String value   = FIELD("value");
+    pack::UInt32 score   = FIELD("score");
+
+    using pack::Node::Node;
+    META(SearchHit, id, name, type, subType, field, value, score);
+};
+
+// =========================================================================================================================================
+
+static constexpr size_t DefaultLimit = 20;
+static constexpr size_t MaxLimit     = 200;
+
+unsigned Search::run()
+{
+    static auto&     stats = metrics::endpoint("asset/search");
+    metrics::Request measure(stats, m_reply);
+
+    metrics::Scope permissions(metrics::Phase::Permissions);
+    rest::User     user(m_request);
+    if (auto ret = checkPermissions(user.profile(), m_permissions); !ret) {
+        throw rest::Error(ret.error());
+    }
+    permissions.stop();
+
+    if (m_request.type() != rest::Request::Type::Get) {
+        throw rest::errors::MethodNotAllowed(m_request.typeStr());
+    }
+
+    auto text = m_request.queryArg<std::string>("q");
+    if (!text || text->empty()) {
+        throw rest::errors::RequestParamRequired("q");
+    }
+    measure.param("q", *text);
+
+    size_t limit = DefaultLimit;
+    if (auto lim = m_request.queryArg<std::string>("limit")) {
+        // digits only: stoul() would accept a sign, spaces and trailing garbage
+        bool number = !lim->empty() && lim->size() <= 6 && std::all_of(lim->begin(), lim->end(), ::isdigit);
+        limit       = number ? std::stoul(*lim) : 0;
+        if (!limit || limit > MaxLimit) {
+            throw rest::errors::RequestParamBad("limit", *lim, "number from 1 to {}"_tr.format(MaxLimit));
+        }
+    }
+
+    std::string type;
+    if (auto typeArg = m_request.queryArg<std::string>("type"); typeArg && !typeArg->empty()) {
+        if (!persist::type_to_typeid(*typeArg)) {
+            throw rest::errors::RequestParamBad("type", *typeArg, "valid type like datacenter, room, etc..."_tr);
+        }
+        type = *typeArg;
+    }
+
+    // the index is only loaded on the first search, and reloaded when it expires
+    metrics::Scope                dbScope(metrics::Phase::Db);
+    std::vector<SearchIndex::Hit> hits;
+    try {
+        hits = SearchIndex::instance().search(*text, limit, type);
+    } catch (const std::exception& e) {
+        throw rest::errors::Internal(e.what());
+    }
+    dbScope.stop();
+
+    metrics::Scope              serialization(metrics::Phase::Serialization);
+    pack::ObjectList<SearchHit> result;
+    for (const auto& hit : hits) {
+        auto& item   = result.append();
+        item.id      = hit.iname;
+        item.name    = hit.name;
+        item.type    = hit.type;
+        item.subType = hit.subType;
+        item.field   = hit.field;
+        item.value   = hit.value;
+        item.score   = hit.score;
+    }
+    m_reply << *pack::json::serialize(result, pack::Option::WithDefaults);
+
+    return HTTP_OK;
+}
+
+} // namespace fty::asset
+
+registerHandler(fty::asset::Search)
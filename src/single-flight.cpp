@@ -0,0 +1,66 @@
+/*  ====================================================================================================================
+    single-flight.cpp - Sharing of identical requests running at the same time
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "single-flight.h"
+#include "metrics.h"
+
+namespace fty::asset {
+
+SingleFlight& SingleFlight::instance()
+{
+    static SingleFlight inst;
+    return inst;
+}
+
+SingleFlight::ReplyPtr SingleFlight::run(const std::string& key, const std::function<Reply()>& func)
+{
+    std::promise<ReplyPtr> promise;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (auto it = m_flights.find(key); it != m_flights.end()) {
+            auto flight = it->second;
+            lock.unlock();
+
+            metrics::coalesced();
+            return flight.get();
+        }
+        m_flights.emplace(key, promise.get_future().share());
+    }
+
+    // the flight is over before the reply is published: later requests compute a fresh one
+    auto land = [&]() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_flights.erase(key);
+    };
+
+    try {
+        auto reply = std::make_shared<const Reply>(func());
+        land();
+        promise.set_value(reply);
+        return reply;
+    } catch (...) {
+        land();
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+} // namespace fty::asset
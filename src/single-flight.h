@@ -0,0 +1,62 @@
+/*  ====================================================================================================================
+    single-flight.h - Sharing of identical requests running at the same time
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fty::asset {
+
+/// Identical requests running at the same time share one execution and its reply: the first one computes it, the
+/// others wait for it. Requests are identical when their keys are, the key must hold everything the reply depends on
+/// (parameters, permission profile, encoding, database...).
+class SingleFlight
+{
+public:
+    struct Reply
+    {
+        unsigned                                         status = 0;
+        std::string                                      contentType;
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::string                                      body;
+    };
+    using ReplyPtr = std::shared_ptr<const Reply>;
+
+    static SingleFlight& instance();
+
+    /// Reply of func, or of the identical call already running. Exceptions are thrown to all the callers.
+    ReplyPtr run(const std::string& key, const std::function<Reply()>& func);
+
+private:
+    SingleFlight() = default;
+
+private:
+    std::mutex                                          m_mutex;
+    std::map<std::string, std::shared_future<ReplyPtr>> m_flights;
+};
+
+} // namespace fty::asset
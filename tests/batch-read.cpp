@@ -0,0 +1,290 @@
+/*  ====================================================================================================================
+    batch-read.cpp - Statements run by the reads of many assets
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+// The listings and bulk requests read their assets through batch reads: the number of statements must not grow with
+// the number of assets. Runs against an in-memory sqlite database, see shim/fty_common_db_connection.h.
+
+#include "batch-read.h"
+#include "db-pool.h"
+#include "metrics.h"
+#include <fmt/format.h>
+#include <fty_common_db_connection.h>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+
+using namespace fty::asset;
+
+static int failures = 0;
+
+#define CHECK(expr)                                                                                                            \
+    do {                                                                                                                       \
+        if (!(expr)) {                                                                                                         \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #expr << std::endl;                                 \
+            ++failures;                                                                                                        \
+        }                                                                                                                      \
+    } while (false)
+
+// clang-format off
+static const char* Schema = R"(
+    CREATE TABLE t_bios_asset_element (
+        id_asset_element INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE, id_type INTEGER NOT NULL,
+        id_subtype INTEGER NOT NULL, id_parent INTEGER, status TEXT NOT NULL, priority INTEGER NOT NULL, asset_tag TEXT);
+    CREATE TABLE t_bios_asset_ext_attributes (
+        id_asset_ext_attribute INTEGER PRIMARY KEY, keytag TEXT NOT NULL, value TEXT NOT NULL,
+        id_asset_element INTEGER NOT NULL, read_only INTEGER NOT NULL);
+    CREATE TABLE t_bios_asset_link_type (id_asset_link_type INTEGER PRIMARY KEY, name TEXT NOT NULL);
+    CREATE TABLE t_bios_asset_link (
+        id_link INTEGER PRIMARY KEY, id_asset_device_src INTEGER NOT NULL, src_out TEXT,
+        id_asset_device_dest INTEGER NOT NULL, dest_in TEXT, id_asset_link_type INTEGER NOT NULL);
+    INSERT INTO t_bios_asset_link_type VALUES (1, 'power chain');
+)";
+// clang-format on
+
+static constexpr uint16_t Datacenter = 2;
+static constexpr uint16_t Device     = 6;
+static constexpr size_t   Assets     = 2500;
+
+// A datacenter (id 1) and devices 2..Assets+1 located in it, each one powered by the previous one
+static void fill(fty::db::Connection& conn)
+{
+    conn.exec(Schema);
+    conn.exec("BEGIN");
+    conn.exec("INSERT INTO t_bios_asset_element VALUES (1, 'datacenter-1', 2, 0, NULL, 'active', 1, NULL)");
+    conn.exec("INSERT INTO t_bios_asset_ext_attributes (keytag, value, id_asset_element, read_only) VALUES ('name', 'DC', 1, 0)");
+    for (size_t id = 2; id <= Assets + 1; ++id) {
+        conn.exec(fmt::format(
+            "INSERT INTO t_bios_asset_element VALUES ({0}, 'device-{0}', {1}, 1, 1, 'active', 2, 'tag-{0}')", id, Device));
+        conn.exec(fmt::format("INSERT INTO t_bios_asset_ext_attributes (keytag, value, id_asset_element, read_only) VALUES "
+                              "('name', 'Device {0}', {0}, 0), ('ip.1', '10.0.0.{0}', {0}, 1), ('logical_asset', 'datacenter-1', {0}, 0)",
+            id));
+        if (id > 2) {
+            conn.exec(fmt::format(
+                "INSERT INTO t_bios_asset_link (id_asset_device_src, src_out, id_asset_device_dest, dest_in, id_asset_link_type) "
+                "VALUES ({}, '1', {}, 'A', 1)",
+                id - 1, id));
+        }
+    }
+    conn.exec("COMMIT");
+}
+
+static std::vector<uint32_t> devices(size_t count)
+{
+    std::vector<uint32_t> ret;
+    for (uint32_t id = 2; ret.size() < count; ++id) {
+        ret.push_back(id);
+    }
+    return ret;
+}
+
+// Statements run by the read
+static uint64_t statements(const std::function<void()>& read)
+{
+    auto before = fty::db::Statement::statements();
+    read();
+    return fty::db::Statement::statements() - before;
+}
+
+// Database calls counted by the request metrics for the read
+static uint64_t dbCalls(const std::function<void()>& read)
+{
+    static auto& stats  = metrics::endpoint("test/batch-read");
+    auto         before = stats.dbCalls.load();
+    {
+        metrics::Request measure(stats);
+        read();
+    }
+    return stats.dbCalls.load() - before;
+}
+
+static void testElements(fty::db::Connection& conn)
+{
+    for (size_t count : {size_t(1), size_t(10), size_t(1000)}) {
+        std::unordered_map<uint32_t, batch::Element> ret;
+        CHECK(statements([&]() {
+            ret = batch::elements(conn, devices(count));
+        }) == 1);
+        CHECK(ret.size() == count);
+    }
+
+    auto ret = batch::elements(conn, {3, 99999});
+    CHECK(ret.size() == 1);
+    CHECK(ret[3].name == "device-3");
+    CHECK(ret[3].extName == "Device 3");
+    CHECK(ret[3].typeId == Device);
+    CHECK(ret[3].priority == 2);
+    CHECK(ret[3].assetTag == "tag-3");
+    CHECK(ret[3].parentId == 1);
+    CHECK(ret[3].parentTypeId == Datacenter);
+    CHECK(ret[3].parentName == "datacenter-1");
+    CHECK(ret[3].parentExtName == "DC");
+
+    // one more statement per batch
+    CHECK(statements([&]() {
+        CHECK(batch::elements(conn, devices(Assets)).size() == Assets);
+    }) == batch::statements(Assets));
+    CHECK(batch::statements(Assets) == 3);
+    CHECK(batch::statements(0) == 0);
+}
+
+static void testAttributes(fty::db::Connection& conn)
+{
+    for (size_t count : {size_t(10), size_t(1000)}) {
+        CHECK(statements([&]() {
+            CHECK(batch::attributes(conn, devices(count)).size() == count);
+        }) == 1);
+    }
+
+    auto ret = batch::attributes(conn, {2});
+    CHECK(ret[2].size() == 3);
+    CHECK(ret[2]["ip.1"].value == "10.0.0.2");
+    CHECK(ret[2]["ip.1"].readOnly);
+    CHECK(!ret[2]["name"].readOnly);
+    CHECK(ret[2]["logical_asset"].value == "datacenter-1");
+    CHECK(ret[2]["logical_asset"].extName == "DC");
+    CHECK(ret[2]["name"].extName.empty());
+}
+
+static void testPowerLinks(fty::db::Connection& conn)
+{
+    for (size_t count : {size_t(10), size_t(1000)}) {
+        CHECK(statements([&]() {
+            CHECK(batch::powerLinks(conn, devices(count)).size() == count - 1);
+        }) == 1);
+    }
+
+    auto ret = batch::powerLinks(conn, {5});
+    CHECK(ret[5].size() == 1);
+    CHECK(ret[5][0].srcName == "device-4");
+    CHECK(ret[5][0].srcExtName == "Device 4");
+    CHECK(ret[5][0].srcSocket == "1");
+    CHECK(ret[5][0].destSocket == "A");
+}
+
+static void testNames(fty::db::Connection& conn)
+{
+    for (size_t count : {size_t(10), size_t(1000)}) {
+        CHECK(statements([&]() {
+            CHECK(batch::extNames(conn, devices(count)).size() == count);
+        }) == 1);
+
+        std::vector<std::string> names;
+        for (auto id : devices(count)) {
+            names.push_back(fmt::format("device-{}", id));
+        }
+        names.back() = "unknown";
+        CHECK(statements([&]() {
+            CHECK(batch::ids(conn, names).size() == count - 1);
+        }) == 1);
+    }
+    CHECK(batch::ids(conn, {"device-7"})["device-7"] == 7);
+    {
+        auto ret = batch::named(conn, {"device-7", "datacenter-1", "unknown"});
+        CHECK(ret.size() == 2);
+        CHECK(ret["device-7"].typeId == Device);
+        CHECK(ret["datacenter-1"].id == 1 && ret["datacenter-1"].typeId == Datacenter);
+    }
+
+    CHECK(statements([&]() {
+        auto ret = batch::extNamesOfType(conn, Device);
+        CHECK(ret.size() == Assets);
+        CHECK(ret[2] == "Device 2");
+    }) == 1);
+}
+
+static void testEndpoints(fty::db::Connection& conn)
+{
+    conn.exec("INSERT INTO t_bios_asset_ext_attributes (keytag, value, id_asset_element, read_only) VALUES "
+              "('endpoint.1.protocol', 'nut_snmp', 2, 0), ('endpoint.1.port', '161', 2, 0), ('endpoint.1.protocol', 'nut_xml_pdc', 3, 0)");
+
+    std::vector<std::string> names;
+    for (auto id : devices(1500)) {
+        names.push_back(fmt::format("device-{}", id));
+    }
+    CHECK(statements([&]() {
+        auto ret = batch::endpoints(conn, names);
+        CHECK(ret.size() == 2);
+        CHECK(ret["device-2"].size() == 2);
+        CHECK(ret["device-3"]["endpoint.1.protocol"] == "nut_xml_pdc");
+    }) == 2);
+}
+
+// Statements are prepared once per leased connection, whatever the number of assets
+static void testPrepared()
+{
+    DbPool::Lease lease;
+    auto&         conn = lease.connection();
+    batch::elements(conn, devices(1));
+
+    auto before = fty::db::Connection::prepared();
+    for (size_t count : {size_t(1), size_t(10), size_t(999), size_t(1000), size_t(Assets)}) {
+        batch::elements(conn, devices(count));
+        batch::attributes(conn, devices(count));
+        batch::extNames(conn, devices(count));
+    }
+    CHECK(fty::db::Connection::prepared() - before == 2);
+}
+
+// A failure of the request itself keeps the connection in the pool
+static void testLease()
+{
+    auto open = DbPool::instance().open();
+    try {
+        DbPool::Lease lease;
+        throw std::invalid_argument("bad parameter");
+    } catch (const std::invalid_argument&) {
+    }
+    CHECK(DbPool::instance().open() == open);
+}
+
+// Each statement is counted once by the request metrics, which the budgets of the handlers rely on
+static void testMetrics(fty::db::Connection& conn)
+{
+    for (size_t count : {size_t(10), size_t(1000), size_t(Assets)}) {
+        auto ids = devices(count);
+        CHECK(dbCalls([&]() {
+            batch::elements(conn, ids);
+            batch::attributes(conn, ids);
+            batch::powerLinks(conn, ids);
+        }) == batch::statements(count, 3));
+    }
+}
+
+int main()
+{
+    fty::db::Connection conn;
+    fill(conn);
+
+    testElements(conn);
+    testAttributes(conn);
+    testPowerLinks(conn);
+    testNames(conn);
+    testEndpoints(conn);
+    testPrepared();
+    testLease();
+    testMetrics(conn);
+
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*  ====================================================================================================================
+    request-body.cpp - Parsing of the request bodies
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+// The create and edit requests read their JSON bodies with JsonReader: malformed documents must be rejected with an
+// error, never crash the server or be read partially.
+
+#include "request-body.h"
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace fty::asset;
+
+static int failures = 0;
+
+#define CHECK(expr)                                                                                                            \
+    do {                                                                                                                       \
+        if (!(expr)) {                                                                                                         \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #expr << std::endl;                                 \
+            ++failures;                                                                                                        \
+        }                                                                                                                      \
+    } while (false)
+
+// Skips the whole document, true if it is valid
+static bool valid(const std::string& text)
+{
+    try {
+        JsonReader reader(text);
+        reader.skip();
+        reader.finish();
+        return true;
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+}
+
+// Value of the only member of the object
+static std::string member(const std::string& text)
+{
+    JsonReader  reader(text);
+    std::string key;
+    reader.enterObject();
+    if (!reader.nextMember(key)) {
+        throw std::runtime_error("no member");
+    }
+    auto value = reader.scalar();
+    if (reader.nextMember(key)) {
+        throw std::runtime_error("more members");
+    }
+    reader.finish();
+    return value;
+}
+
+// =========================================================================================================================================
+
+static void testNesting()
+{
+    auto nested = [](size_t depth) {
+        return std::string(depth, '[') + std::string(depth, ']');
+    };
+
+    CHECK(valid(nested(1)));
+    CHECK(valid(nested(JsonReader::MaxDepth)));
+    CHECK(!valid(nested(JsonReader::MaxDepth + 1)));
+    // rejected before the recursion gets deep, not by a stack overflow
+    CHECK(!valid(nested(1000000)));
+    CHECK(!valid(std::string(1000000, '[')));
+
+    std::string objects;
+    for (size_t i = 0; i <= JsonReader::MaxDepth; ++i) {
+        objects += R"({"a":)";
+    }
+    objects += "1" + std::string(JsonReader::MaxDepth + 1, '}');
+    CHECK(!valid(objects));
+
+    CHECK(valid(R"({"a": [1, {"b": [true, null]}], "c": {}})"));
+    CHECK(!valid("[1, 2"));
+    CHECK(!valid(R"({"a": 1)"));
+    CHECK(!valid("[1, 2}"));
+    CHECK(!valid("[1,]"));
+    CHECK(!valid(R"({"a": 1,})"));
+}
+
+static void testStrings()
+{
+    CHECK(member(R"({"a": "plain"})") == "plain");
+    CHECK(member(R"({"a": "q\"b\\s\/"})") == "q\"b\\s/");
+    CHECK(member(R"({"a": "\b\f\n\r\t"})") == "\b\f\n\r\t");
+    CHECK(member(R"({"a": "Aé€"})") == "A\xc3\xa9\xe2\x82\xac");
+    CHECK(member(R"({"a": "😀"})") == "\xf0\x9f\x98\x80");
+
+    CHECK(!valid(R"("\x")"));
+    CHECK(!valid(R"("\u12")"));
+    CHECK(!valid(R"("\u12g4")"));
+    CHECK(!valid(R"("\ud83dA")"));
+    CHECK(!valid(R"("\ude00")"));
+    CHECK(!valid(R"("\ud83d\u0041")"));
+    CHECK(!valid(R"("unterminated)"));
+    CHECK(!valid(R"("unterminated\)"));
+
+    // raw control characters must be escaped
+    CHECK(!valid("\"tab\there\""));
+    CHECK(!valid("\"new\nline\""));
+    CHECK(!valid(std::string("\"nul\0\"", 6)));
+    CHECK(valid("\"del\x7f\""));
+}
+
+static void testNumbers()
+{
+    for (const char* number : {"0", "-0", "1", "-12", "10.5", "0.25", "1e5", "1E+5", "2.5e-3"}) {
+        CHECK(valid(number));
+        CHECK(member(std::string(R"({"a": )") + number + "}") == number);
+    }
+    for (const char* number : {"01", "+1", "1.", ".5", "-", "1e", "1e+", "0x10", "1.2.3", "--1", "1-2", "NaN", "Infinity"}) {
+        CHECK(!valid(number));
+    }
+
+    CHECK(valid("true"));
+    CHECK(valid("false"));
+    CHECK(valid("null"));
+    CHECK(member(R"({"a": null})").empty());
+    CHECK(!valid("True"));
+    CHECK(!valid("nul"));
+}
+
+static void testTrailing()
+{
+    CHECK(valid(" [1] \n\t"));
+    CHECK(!valid("[1] [2]"));
+    CHECK(!valid("[1]x"));
+    CHECK(!valid(R"({"a": 1}})"));
+    CHECK(!valid(std::string("[1]\0", 4)));
+    CHECK(!valid(""));
+    CHECK(!valid("   "));
+}
+
+int main()
+{
+    testNesting();
+    testStrings();
+    testNumbers();
+    testTrailing();
+
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
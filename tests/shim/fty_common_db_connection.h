@@ -0,0 +1,179 @@
+/*  ====================================================================================================================
+    fty_common_db_connection.h - Database connection of the tests, over sqlite
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+// Stands in for the connection of fty-common-db in the offline tests: same interface (the part used by the library),
+// one in-memory sqlite database shared by all the connections, and counters of the statements prepared and run.
+
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <sqlite3.h>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace fty::db {
+
+class Row
+{
+public:
+    template <typename T = std::string>
+    T get(const std::string& col) const
+    {
+        auto it = m_values.find(col);
+        if (it == m_values.end()) {
+            throw std::runtime_error("No column " + col);
+        }
+        if constexpr (std::is_same_v<T, std::string>) {
+            return it->second;
+        } else if constexpr (std::is_same_v<T, bool>) {
+            return !it->second.empty() && it->second != "0";
+        } else {
+            return it->second.empty() ? T{} : T(std::stoll(it->second));
+        }
+    }
+
+private:
+    friend class Statement;
+    std::map<std::string, std::string> m_values;
+};
+
+using Rows = std::vector<Row>;
+
+class Statement
+{
+public:
+    template <typename T>
+    Statement& bind(const std::string& name, const T& value)
+    {
+        int index = sqlite3_bind_parameter_index(m_stmt.get(), (":" + name).c_str());
+        if (!index) {
+            throw std::runtime_error("No parameter " + name);
+        }
+        if constexpr (std::is_same_v<T, std::string>) {
+            sqlite3_bind_text(m_stmt.get(), index, value.c_str(), int(value.size()), SQLITE_TRANSIENT);
+        } else {
+            sqlite3_bind_int64(m_stmt.get(), index, sqlite3_int64(value));
+        }
+        return *this;
+    }
+
+    Rows select() const
+    {
+        ++statements();
+        sqlite3_reset(m_stmt.get());
+
+        Rows rows;
+        int  rc;
+        while ((rc = sqlite3_step(m_stmt.get())) == SQLITE_ROW) {
+            Row& row = rows.emplace_back();
+            for (int col = 0; col < sqlite3_column_count(m_stmt.get()); ++col) {
+                auto text = reinterpret_cast<const char*>(sqlite3_column_text(m_stmt.get(), col));
+                row.m_values[sqlite3_column_name(m_stmt.get(), col)] = text ? text : "";
+            }
+        }
+        if (rc != SQLITE_DONE) {
+            throw std::runtime_error(sqlite3_errmsg(sqlite3_db_handle(m_stmt.get())));
+        }
+        return rows;
+    }
+
+    Row selectRow() const
+    {
+        auto rows = select();
+        if (rows.size() != 1) {
+            throw std::runtime_error("Expected one row");
+        }
+        return rows.front();
+    }
+
+    uint64_t execute() const
+    {
+        return select().size();
+    }
+
+    /// Statements run since the start of the test
+    static uint64_t& statements()
+    {
+        static uint64_t count = 0;
+        return count;
+    }
+
+private:
+    friend class Connection;
+    std::shared_ptr<sqlite3_stmt> m_stmt;
+};
+
+class Connection
+{
+public:
+    Connection() = default;
+
+    explicit Connection(const std::string&)
+    {
+    }
+
+    Statement prepare(const std::string& sql)
+    {
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error(sqlite3_errmsg(db()));
+        }
+        ++prepared();
+
+        Statement st;
+        st.m_stmt.reset(stmt, sqlite3_finalize);
+        return st;
+    }
+
+    /// Runs statements without counting them, to fill the database
+    void exec(const std::string& sql)
+    {
+        char* error = nullptr;
+        if (sqlite3_exec(db(), sql.c_str(), nullptr, nullptr, &error) != SQLITE_OK) {
+            std::string msg = error;
+            sqlite3_free(error);
+            throw std::runtime_error(msg);
+        }
+    }
+
+    /// Statements prepared since the start of the test
+    static uint64_t& prepared()
+    {
+        static uint64_t count = 0;
+        return count;
+    }
+
+private:
+    static sqlite3* db()
+    {
+        static sqlite3* handle = []() {
+            sqlite3* ret = nullptr;
+            sqlite3_open(":memory:", &ret);
+            return ret;
+        }();
+        return handle;
+    }
+};
+
+} // namespace fty::db
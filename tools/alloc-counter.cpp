@@ -0,0 +1,142 @@
+/*  ====================================================================================================================
+    alloc-counter.cpp - Counts the allocations of the web server, preloaded with LD_PRELOAD
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+// Start the web server with LD_PRELOAD=libfty-asset-alloc-counter.so, then give its pid to fty-asset-bench.
+// Every allocation of the process is counted (all the tntnet components, not only this library), so nothing else
+// should load the server during a bench.
+
+#include "alloc-counter.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using fty::asset::bench::AllocCounters;
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void  __libc_free(void* ptr);
+}
+
+namespace {
+
+// counts made before the shared memory is mapped (loader, static constructors) stay here
+AllocCounters  localCounters;
+AllocCounters* counters = &localCounters;
+
+void allocated(size_t size)
+{
+    counters->allocations.fetch_add(1, std::memory_order_relaxed);
+    counters->bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void freed(void* ptr)
+{
+    if (ptr) {
+        counters->frees.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+__attribute__((constructor)) void mapCounters()
+{
+    auto name = fty::asset::bench::allocCountersName(getpid());
+    int  fd   = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+    if (fd < 0) {
+        return;
+    }
+    if (ftruncate(fd, sizeof(AllocCounters)) != 0) {
+        close(fd);
+        return;
+    }
+    void* mem = mmap(nullptr, sizeof(AllocCounters), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        return;
+    }
+
+    auto shared = new (mem) AllocCounters;
+    shared->allocations = localCounters.allocations.load();
+    shared->frees       = localCounters.frees.load();
+    shared->bytes       = localCounters.bytes.load();
+    counters            = shared;
+}
+
+__attribute__((destructor)) void unlinkCounters()
+{
+    shm_unlink(fty::asset::bench::allocCountersName(getpid()).c_str());
+}
+
+} // namespace
+
+extern "C" {
+
+void* malloc(size_t size)
+{
+    allocated(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    allocated(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    // a moved block is one allocation and one free, the counters do not know whether it moved
+    allocated(size);
+    freed(ptr);
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    allocated(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    void* mem = memalign(alignment, size);
+    if (!mem) {
+        return ENOMEM;
+    }
+    *ptr = mem;
+    return 0;
+}
+
+void free(void* ptr)
+{
+    freed(ptr);
+    __libc_free(ptr);
+}
+
+} // extern "C"
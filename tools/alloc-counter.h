@@ -0,0 +1,45 @@
+/*  ====================================================================================================================
+    alloc-counter.h - Allocation counters shared by a preloaded process and the bench
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+// The counters live in a POSIX shared memory object named after the pid of the counted process, so the bench reads them
+// while the web server runs.
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+
+namespace fty::asset::bench {
+
+struct AllocCounters
+{
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> frees{0};
+    std::atomic<uint64_t> bytes{0};
+};
+
+inline std::string allocCountersName(pid_t pid)
+{
+    return "/fty-asset-alloc-" + std::to_string(pid);
+}
+
+} // namespace fty::asset::bench
@@ -0,0 +1,579 @@
+/*  ====================================================================================================================
+    asset-bench.cpp - Load driver of the asset endpoints
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+// Drives the asset endpoints of a running web server, one scenario after the other, and reports per scenario the
+// throughput, the latency percentiles and, when the server runs with the allocation counter preloaded, the allocations
+// per request.
+//
+// The database is seeded beforehand, with fty-asset-inventory-generator and the import endpoint or its SQL script.
+
+#include "alloc-counter.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    std::string host     = "127.0.0.1";
+    std::string port     = "80";
+    std::string token;
+    unsigned    pid      = 0;
+    unsigned    clients  = 4;
+    unsigned    duration = 10;
+    unsigned    requests = 0;
+    std::string dc;
+    std::string asset;
+    std::string rack;
+    std::string csv;
+
+    std::vector<std::string> scenarios;
+};
+
+void usage()
+{
+    std::cerr << R"(Usage: fty-asset-bench [options] scenario...
+
+Server
+    --host HOST      web server, plain http (127.0.0.1)
+    --port PORT      port of the web server (80)
+    --token TOKEN    bearer token of an admin session
+    --server-pid N   pid of the web server started with LD_PRELOAD=libfty-asset-alloc-counter.so,
+                     to report its allocations
+
+Load
+    --clients N      concurrent connections (4)
+    --duration N     seconds per scenario (10)
+    --requests N     requests per scenario, stops it before the duration (0, no limit)
+
+Assets
+    --dc NAME        datacenter (internal name) listed and exported
+    --asset NAME     asset (internal name) read
+    --rack NAME      rack (internal name) checked by check-usize
+    --csv FILE       document posted by import, at most 128 kB
+
+Scenarios
+    list-in          GET /api/v1/assets?in=<dc>
+    list-in-details  GET /api/v1/assets?in=<dc>&details=true
+    list             GET /api/v1/asset/devices
+    read             GET /api/v1/asset/<asset>
+    export           GET /api/v1/asset/export?dc=<dc>
+    import           POST /api/v1/asset/import with <csv>
+    check-usize      POST /api/v1/asset/fit_in_rack with <rack>
+)";
+}
+
+Options parse(int argc, char** argv)
+{
+    Options opt;
+
+    std::map<std::string, unsigned*> numbers = {
+        {"--server-pid", &opt.pid},
+        {"--clients", &opt.clients},
+        {"--duration", &opt.duration},
+        {"--requests", &opt.requests},
+    };
+    std::map<std::string, std::string*> strings = {
+        {"--host", &opt.host},
+        {"--port", &opt.port},
+        {"--token", &opt.token},
+        {"--dc", &opt.dc},
+        {"--asset", &opt.asset},
+        {"--rack", &opt.rack},
+        {"--csv", &opt.csv},
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            usage();
+            std::exit(EXIT_SUCCESS);
+        }
+        if (arg.compare(0, 2, "--") != 0) {
+            opt.scenarios.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            throw std::runtime_error("missing value of " + arg);
+        }
+        if (auto it = numbers.find(arg); it != numbers.end()) {
+            *it->second = unsigned(std::stoul(argv[++i]));
+        } else if (auto str = strings.find(arg); str != strings.end()) {
+            *str->second = argv[++i];
+        } else {
+            throw std::runtime_error("unknown option " + arg);
+        }
+    }
+
+    if (opt.scenarios.empty()) {
+        throw std::runtime_error("no scenario");
+    }
+    if (!opt.clients) {
+        throw std::runtime_error("no client");
+    }
+    return opt;
+}
+
+// =========================================================================================================================================
+
+struct HttpRequest
+{
+    std::string method = "GET";
+    std::string path;
+    std::string contentType;
+    std::string body;
+};
+
+// Minimal HTTP/1.1 client on a kept-alive connection, reconnected when the server closes it
+class Connection
+{
+public:
+    Connection(const Options& opt)
+        : m_opt(opt)
+    {
+    }
+
+    ~Connection()
+    {
+        disconnect();
+    }
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    // Status of the reply, the body is read and dropped
+    unsigned send(const HttpRequest& request)
+    {
+        std::string out = request.method + " " + request.path + " HTTP/1.1\r\nHost: " + m_opt.host + "\r\n";
+        if (!m_opt.token.empty()) {
+            out += "Authorization: Bearer " + m_opt.token + "\r\n";
+        }
+        if (!request.contentType.empty()) {
+            out += "Content-Type: " + request.contentType + "\r\n";
+        }
+        if (request.method != "GET") {
+            out += "Content-Length: " + std::to_string(request.body.size()) + "\r\n";
+        }
+        out += "\r\n" + request.body;
+
+        // a kept-alive connection may have been closed by the server meanwhile, try again once on a new one
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            if (m_fd < 0) {
+                connect();
+            }
+            if (write(out)) {
+                try {
+                    return readReply();
+                } catch (const std::exception&) {
+                    if (attempt || m_received) {
+                        throw;
+                    }
+                }
+            }
+            disconnect();
+        }
+        throw std::runtime_error("cannot send the request");
+    }
+
+private:
+    void connect()
+    {
+        addrinfo hints{};
+        hints.ai_family   = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        addrinfo* addrs = nullptr;
+        if (int ret = getaddrinfo(m_opt.host.c_str(), m_opt.port.c_str(), &hints, &addrs); ret != 0) {
+            throw std::runtime_error(std::string("cannot resolve the server: ") + gai_strerror(ret));
+        }
+
+        for (auto addr = addrs; addr; addr = addr->ai_next) {
+            m_fd = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+            if (m_fd >= 0 && ::connect(m_fd, addr->ai_addr, addr->ai_addrlen) == 0) {
+                // requests are small and sent at once, waiting to fill segments only adds latency
+                int noDelay = 1;
+                setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+                break;
+            }
+            disconnect();
+        }
+        freeaddrinfo(addrs);
+
+        if (m_fd < 0) {
+            throw std::runtime_error("cannot connect to " + m_opt.host + ":" + m_opt.port);
+        }
+        m_buffer.clear();
+    }
+
+    void disconnect()
+    {
+        if (m_fd >= 0) {
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    bool write(const std::string& data)
+    {
+        size_t done = 0;
+        while (done < data.size()) {
+            auto ret = ::send(m_fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+            if (ret <= 0) {
+                return false;
+            }
+            done += size_t(ret);
+        }
+        return true;
+    }
+
+    // Reads more data into the buffer
+    void fill()
+    {
+        char buf[16384];
+        auto ret = recv(m_fd, buf, sizeof(buf), 0);
+        if (ret <= 0) {
+            throw std::runtime_error("connection closed by the server");
+        }
+        m_received = true;
+        m_buffer.append(buf, size_t(ret));
+    }
+
+    std::string line()
+    {
+        size_t end;
+        while ((end = m_buffer.find("\r\n")) == std::string::npos) {
+            fill();
+        }
+        std::string ret = m_buffer.substr(0, end);
+        m_buffer.erase(0, end + 2);
+        return ret;
+    }
+
+    void skip(size_t size)
+    {
+        while (m_buffer.size() < size) {
+            fill();
+        }
+        m_buffer.erase(0, size);
+    }
+
+    unsigned readReply()
+    {
+        m_received = false;
+
+        std::string status = line();
+        if (status.compare(0, 5, "HTTP/") != 0 || status.size() < 12) {
+            throw std::runtime_error("bad reply: " + status);
+        }
+        unsigned code = unsigned(std::stoul(status.substr(9, 3)));
+
+        size_t length  = 0;
+        bool   chunked = false;
+        bool   keep    = status.compare(0, 8, "HTTP/1.1") == 0;
+        for (std::string header = line(); !header.empty(); header = line()) {
+            std::string name = header.substr(0, header.find(':'));
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            std::string value = header.substr(std::min(header.size(), name.size() + 1));
+            value.erase(0, value.find_first_not_of(' '));
+
+            if (name == "content-length") {
+                length = std::stoul(value);
+            } else if (name == "transfer-encoding") {
+                chunked = value.find("chunked") != std::string::npos;
+            } else if (name == "connection") {
+                keep = value.find("close") == std::string::npos && value.find("Close") == std::string::npos;
+            }
+        }
+
+        if (chunked) {
+            for (size_t chunk = std::stoul(line(), nullptr, 16); chunk; chunk = std::stoul(line(), nullptr, 16)) {
+                skip(chunk + 2);
+            }
+            // trailers
+            while (!line().empty()) {
+            }
+        } else {
+            skip(length);
+        }
+
+        if (!keep) {
+            disconnect();
+        }
+        return code;
+    }
+
+private:
+    const Options& m_opt;
+    int            m_fd       = -1;
+    bool           m_received = false;
+    std::string    m_buffer;
+};
+
+// =========================================================================================================================================
+
+std::string readFile(const std::string& name)
+{
+    std::ifstream in(name, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("cannot read " + name);
+    }
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+std::string required(const std::string& value, const std::string& option, const std::string& scenario)
+{
+    if (value.empty()) {
+        throw std::runtime_error(scenario + " needs " + option);
+    }
+    return value;
+}
+
+HttpRequest scenarioRequest(const Options& opt, const std::string& name)
+{
+    HttpRequest req;
+    if (name == "list-in") {
+        req.path = "/api/v1/assets?in=" + required(opt.dc, "--dc", name);
+    } else if (name == "list-in-details") {
+        req.path = "/api/v1/assets?in=" + required(opt.dc, "--dc", name) + "&details=true";
+    } else if (name == "list") {
+        req.path = "/api/v1/asset/devices";
+    } else if (name == "read") {
+        req.path = "/api/v1/asset/" + required(opt.asset, "--asset", name);
+    } else if (name == "export") {
+        req.path = "/api/v1/asset/export?dc=" + required(opt.dc, "--dc", name);
+    } else if (name == "import") {
+        static const std::string boundary = "fty-asset-bench-boundary";
+
+        req.method      = "POST";
+        req.path        = "/api/v1/asset/import";
+        req.contentType = "multipart/form-data; boundary=" + boundary;
+        req.body        = "--" + boundary + "\r\n";
+        req.body += "Content-Disposition: form-data; name=\"assets\"; filename=\"assets.csv\"\r\n";
+        req.body += "Content-Type: text/csv\r\n\r\n";
+        req.body += readFile(required(opt.csv, "--csv", name));
+        req.body += "\r\n--" + boundary + "--\r\n";
+    } else if (name == "check-usize") {
+        req.method      = "POST";
+        req.path        = "/api/v1/asset/fit_in_rack";
+        req.contentType = "application/json";
+        req.body        = R"({"rack_id": ")" + required(opt.rack, "--rack", name) + R"(", "asset_size": 1, "asset_position": 1})";
+    } else {
+        throw std::runtime_error("unknown scenario " + name);
+    }
+    return req;
+}
+
+// =========================================================================================================================================
+
+// Allocations of the web server, read from the counters of the preloaded library
+class ServerAllocs
+{
+public:
+    explicit ServerAllocs(unsigned pid)
+    {
+        if (!pid) {
+            return;
+        }
+        auto name = fty::asset::bench::allocCountersName(pid_t(pid));
+        int  fd   = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            throw std::runtime_error("no allocation counters for pid " + std::to_string(pid) + ", is the server preloaded?");
+        }
+        void* mem = mmap(nullptr, sizeof(fty::asset::bench::AllocCounters), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mem == MAP_FAILED) {
+            throw std::runtime_error("cannot map " + name);
+        }
+        m_counters = static_cast<const fty::asset::bench::AllocCounters*>(mem);
+    }
+
+    ~ServerAllocs()
+    {
+        if (m_counters) {
+            munmap(const_cast<fty::asset::bench::AllocCounters*>(m_counters), sizeof(fty::asset::bench::AllocCounters));
+        }
+    }
+
+    bool enabled() const
+    {
+        return m_counters;
+    }
+
+    std::pair<uint64_t, uint64_t> read() const
+    {
+        if (!m_counters) {
+            return {0, 0};
+        }
+        return {m_counters->allocations.load(std::memory_order_relaxed), m_counters->bytes.load(std::memory_order_relaxed)};
+    }
+
+private:
+    const fty::asset::bench::AllocCounters* m_counters = nullptr;
+};
+
+struct Result
+{
+    uint64_t              requests = 0;
+    uint64_t              errors   = 0;
+    double                seconds  = 0;
+    std::vector<uint64_t> latencies; // microseconds, sorted
+    uint64_t              allocations = 0;
+    uint64_t              bytes       = 0;
+};
+
+Result runScenario(const Options& opt, const HttpRequest& request, const ServerAllocs& allocs)
+{
+    std::atomic<uint64_t> started{0};
+    std::atomic<bool>     stop{false};
+    auto                  deadline = Clock::now() + std::chrono::seconds(opt.duration);
+
+    std::vector<std::vector<uint64_t>> latencies(opt.clients);
+    std::vector<uint64_t>              errors(opt.clients, 0);
+
+    auto client = [&](size_t index) {
+        Connection conn(opt);
+        while (!stop && Clock::now() < deadline) {
+            if (opt.requests && started++ >= opt.requests) {
+                break;
+            }
+            auto start = Clock::now();
+            bool ok    = false;
+            try {
+                auto status = conn.send(request);
+                ok          = status >= 200 && status < 300;
+            } catch (const std::exception& e) {
+                std::cerr << "error: " << e.what() << std::endl;
+            }
+            latencies[index].push_back(
+                uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count()));
+            if (!ok) {
+                ++errors[index];
+            }
+        }
+    };
+
+    auto allocsBefore = allocs.read();
+    auto start        = Clock::now();
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < opt.clients; ++i) {
+        threads.emplace_back(client, i);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto elapsed     = Clock::now() - start;
+    auto allocsAfter = allocs.read();
+
+    Result ret;
+    ret.seconds     = std::chrono::duration<double>(elapsed).count();
+    ret.allocations = allocsAfter.first - allocsBefore.first;
+    ret.bytes       = allocsAfter.second - allocsBefore.second;
+
+    for (size_t i = 0; i < opt.clients; ++i) {
+        ret.errors += errors[i];
+        ret.latencies.insert(ret.latencies.end(), latencies[i].begin(), latencies[i].end());
+    }
+    ret.requests = ret.latencies.size();
+    std::sort(ret.latencies.begin(), ret.latencies.end());
+    return ret;
+}
+
+double percentileMs(const std::vector<uint64_t>& sorted, double q)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = std::min(sorted.size() - 1, size_t(q * double(sorted.size())));
+    return double(sorted[index]) / 1000.;
+}
+
+void report(const std::string& name, const Result& result, bool allocs)
+{
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(1) << std::setw(9)
+              << result.requests << std::setw(8) << result.errors << std::setw(10)
+              << (result.seconds > 0 ? double(result.requests) / result.seconds : 0.) << std::setw(10)
+              << percentileMs(result.latencies, 0.5) << std::setw(10) << percentileMs(result.latencies, 0.95) << std::setw(10)
+              << percentileMs(result.latencies, 0.99) << std::setw(10)
+              << (result.latencies.empty() ? 0. : double(result.latencies.back()) / 1000.);
+    if (allocs && result.requests) {
+        std::cout << std::setw(12) << double(result.allocations) / double(result.requests) << std::setw(12)
+                  << double(result.bytes) / double(result.requests);
+    }
+    std::cout << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try {
+        Options      opt = parse(argc, argv);
+        ServerAllocs allocs(opt.pid);
+
+        // requests are built first, a missing option is reported before any load
+        std::vector<HttpRequest> requests;
+        for (const auto& name : opt.scenarios) {
+            requests.push_back(scenarioRequest(opt, name));
+        }
+
+        std::cout << std::left << std::setw(16) << "scenario" << std::right << std::setw(9) << "requests" << std::setw(8)
+                  << "errors" << std::setw(10) << "req/s" << std::setw(10) << "p50 ms" << std::setw(10) << "p95 ms"
+                  << std::setw(10) << "p99 ms" << std::setw(10) << "max ms";
+        if (allocs.enabled()) {
+            std::cout << std::setw(12) << "allocs/req" << std::setw(12) << "bytes/req";
+        }
+        std::cout << std::endl;
+
+        for (size_t i = 0; i < requests.size(); ++i) {
+            report(opt.scenarios[i], runScenario(opt, requests[i], allocs), allocs.enabled());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        usage();
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,448 @@
+/*  ====================================================================================================================
+    inventory-generator.cpp - Synthetic inventory for scale tests
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+// Generates an inventory as the CSV accepted by the import (POST /api/v1/asset/import), and optionally as a SQL script
+// loading the same inventory directly into the database.
+//
+// Topology: datacenters > rooms > rows > racks > devices. Every room has a feed powering a chain of UPSes, every rack
+// has ePDUs powered by the last UPS of its room, and the devices of a rack are powered by the ePDUs of the rack.
+
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options
+{
+    unsigned    dcs        = 1;
+    unsigned    rooms      = 2;
+    unsigned    rows       = 4;
+    unsigned    racks      = 10;
+    unsigned    devices    = 20;
+    unsigned    rackSize   = 42;
+    unsigned    deviceSize = 1;
+    unsigned    upsChain   = 1;
+    unsigned    inputs     = 2;
+    unsigned    outlets    = 24;
+    unsigned    ext        = 5;
+    unsigned    seed       = 1;
+    unsigned    firstId    = 1000000;
+    std::string csv;
+    std::string sql;
+};
+
+struct Asset
+{
+    uint32_t                           id     = 0;
+    std::string                        name;
+    std::string                        type;
+    std::string                        subType;
+    const Asset*                       parent = nullptr;
+    std::map<std::string, std::string> ext;
+
+    struct Power
+    {
+        const Asset* source;
+        std::string  outlet;
+        std::string  input;
+    };
+    std::vector<Power> powers;
+
+    std::string iname() const
+    {
+        return (subType.empty() ? type : subType) + "-" + std::to_string(id);
+    }
+};
+
+void usage()
+{
+    std::cerr << R"(Usage: fty-asset-inventory-generator [options]
+
+Topology
+    --dcs N          datacenters (1)
+    --rooms N        rooms per datacenter (2)
+    --rows N         rows per room (4)
+    --racks N        racks per row (10)
+    --devices N      devices per rack (20)
+    --rack-size N    rack size in U (42)
+    --device-size N  device size in U (1)
+
+Power
+    --ups-chain N    UPSes chained behind the feed of a room (1)
+    --inputs N       power inputs per device, also ePDUs per rack (2)
+    --outlets N      outlets per ePDU (24)
+
+Attributes
+    --ext N          additional ext attributes per device (5)
+    --seed N         seed of the generated values (1)
+
+Output
+    --csv FILE       import CSV (standard output)
+    --sql FILE       SQL script inserting the same inventory directly
+    --first-id N     first database id used by the SQL script (1000000)
+)";
+}
+
+Options parse(int argc, char** argv)
+{
+    Options opt;
+
+    std::map<std::string, unsigned*> numbers = {
+        {"--dcs", &opt.dcs},
+        {"--rooms", &opt.rooms},
+        {"--rows", &opt.rows},
+        {"--racks", &opt.racks},
+        {"--devices", &opt.devices},
+        {"--rack-size", &opt.rackSize},
+        {"--device-size", &opt.deviceSize},
+        {"--ups-chain", &opt.upsChain},
+        {"--inputs", &opt.inputs},
+        {"--outlets", &opt.outlets},
+        {"--ext", &opt.ext},
+        {"--seed", &opt.seed},
+        {"--first-id", &opt.firstId},
+    };
+    std::map<std::string, std::string*> strings = {
+        {"--csv", &opt.csv},
+        {"--sql", &opt.sql},
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            usage();
+            std::exit(EXIT_SUCCESS);
+        }
+        if (i + 1 >= argc) {
+            throw std::runtime_error("missing value of " + arg);
+        }
+        if (auto it = numbers.find(arg); it != numbers.end()) {
+            *it->second = unsigned(std::stoul(argv[++i]));
+        } else if (auto str = strings.find(arg); str != strings.end()) {
+            *str->second = argv[++i];
+        } else {
+            throw std::runtime_error("unknown option " + arg);
+        }
+    }
+
+    if (!opt.deviceSize || opt.devices * opt.deviceSize > opt.rackSize) {
+        throw std::runtime_error("devices do not fit in the racks");
+    }
+    if (opt.inputs > opt.outlets && opt.devices) {
+        throw std::runtime_error("not enough outlets");
+    }
+    return opt;
+}
+
+// =========================================================================================================================================
+
+class Generator
+{
+public:
+    explicit Generator(const Options& opt)
+        : m_opt(opt)
+        , m_nextId(opt.firstId)
+        , m_random(opt.seed)
+    {
+    }
+
+    // deque: addresses of the assets are kept as parents and power sources
+    const std::deque<Asset>& generate()
+    {
+        for (unsigned dc = 1; dc <= m_opt.dcs; ++dc) {
+            auto& dcAsset = add("datacenter", "", fmt("DC", dc), nullptr);
+            for (unsigned room = 1; room <= m_opt.rooms; ++room) {
+                generateRoom(dcAsset, room);
+            }
+        }
+        return m_assets;
+    }
+
+private:
+    void generateRoom(const Asset& dc, unsigned index)
+    {
+        auto& room = add("room", "", fmt(dc.name + "-Room", index), &dc);
+
+        const Asset* source = &add("device", "feed", fmt(room.name + "-Feed", 1), &room);
+        for (unsigned i = 1; i <= m_opt.upsChain; ++i) {
+            auto& ups = add("device", "ups", fmt(room.name + "-UPS", i), &room);
+            ups.powers.push_back({source, "", "1"});
+            source = &ups;
+        }
+
+        for (unsigned row = 1; row <= m_opt.rows; ++row) {
+            auto& rowAsset = add("row", "", fmt(room.name + "-Row", row), &room);
+            for (unsigned rack = 1; rack <= m_opt.racks; ++rack) {
+                generateRack(rowAsset, rack, *source);
+            }
+        }
+    }
+
+    void generateRack(const Asset& row, unsigned index, const Asset& ups)
+    {
+        auto& rack               = add("rack", "", fmt(row.name + "-Rack", index), &row);
+        rack.ext["u_size"]       = std::to_string(m_opt.rackSize);
+        rack.ext["contact_name"] = "Facility";
+
+        std::vector<const Asset*> epdus;
+        for (unsigned i = 1; i <= m_opt.inputs; ++i) {
+            auto& epdu = add("device", "epdu", fmt(rack.name + "-ePDU", i), &rack);
+            epdu.powers.push_back({&ups, "", "1"});
+            epdu.ext["manufacturer"] = "Eaton";
+            epdu.ext["model"]        = "ePDU G3";
+            epdu.ext["serial_no"]    = serial();
+            for (unsigned outlet = 1; outlet <= m_opt.outlets; ++outlet) {
+                epdu.ext["outlet." + std::to_string(outlet) + ".label"] = fmt("Outlet ", outlet);
+            }
+            epdus.push_back(&epdu);
+        }
+
+        for (unsigned i = 0; i < m_opt.devices; ++i) {
+            auto& dev                 = add("device", "server", fmt(rack.name + "-Server", i + 1), &rack);
+            dev.ext["u_size"]         = std::to_string(m_opt.deviceSize);
+            dev.ext["location_u_pos"] = std::to_string(1 + i * m_opt.deviceSize);
+            dev.ext["manufacturer"]   = "Generic";
+            dev.ext["model"]          = fmt("Server-", 1 + m_random() % 10);
+            dev.ext["serial_no"]      = serial();
+            dev.ext["ip.1"]           = ip(dev.id);
+            for (unsigned e = 1; e <= m_opt.ext; ++e) {
+                dev.ext[fmt("custom.", e)] = fmt("value-", m_random() % 1000);
+            }
+            for (unsigned input = 0; input < epdus.size(); ++input) {
+                dev.powers.push_back({epdus[input], std::to_string(1 + i % m_opt.outlets), std::to_string(input + 1)});
+            }
+        }
+    }
+
+    Asset& add(const std::string& type, const std::string& subType, const std::string& name, const Asset* parent)
+    {
+        auto& asset   = m_assets.emplace_back();
+        asset.id      = m_nextId++;
+        asset.type    = type;
+        asset.subType = subType;
+        asset.name    = name;
+        asset.parent  = parent;
+        return asset;
+    }
+
+    std::string serial()
+    {
+        return fmt("SN", 10000000 + m_random() % 90000000);
+    }
+
+    static std::string ip(uint32_t id)
+    {
+        return fmt("10." + std::to_string((id >> 16) & 0xff) + "." + std::to_string((id >> 8) & 0xff) + ".", id & 0xff);
+    }
+
+    static std::string fmt(const std::string& prefix, uint64_t num)
+    {
+        return prefix + std::to_string(num);
+    }
+
+private:
+    const Options&    m_opt;
+    uint32_t          m_nextId;
+    std::mt19937      m_random;
+    std::deque<Asset> m_assets;
+};
+
+// =========================================================================================================================================
+
+std::string csvEscape(const std::string& value)
+{
+    if (value.find_first_of(",\"\n") == std::string::npos) {
+        return value;
+    }
+    std::string ret = "\"";
+    for (char ch : value) {
+        if (ch == '"') {
+            ret += '"';
+        }
+        ret += ch;
+    }
+    return ret + "\"";
+}
+
+void writeCsv(std::ostream& out, const std::deque<Asset>& assets, const Options& opt)
+{
+    std::vector<std::string> columns = {"name", "type", "sub_type", "location", "status", "priority"};
+    for (unsigned i = 1; i <= opt.inputs; ++i) {
+        columns.push_back("power_source." + std::to_string(i));
+        columns.push_back("power_plug_src." + std::to_string(i));
+        columns.push_back("power_input." + std::to_string(i));
+    }
+
+    // all the ext attributes used, in a stable order
+    std::map<std::string, bool> ext;
+    for (const auto& asset : assets) {
+        for (const auto& [key, value] : asset.ext) {
+            ext.emplace(key, true);
+        }
+    }
+    for (const auto& [key, used] : ext) {
+        columns.push_back(key);
+    }
+
+    for (size_t i = 0; i < columns.size(); ++i) {
+        out << (i ? "," : "") << columns[i];
+    }
+    out << "\n";
+
+    for (const auto& asset : assets) {
+        out << csvEscape(asset.name) << "," << asset.type << "," << asset.subType << ","
+            << (asset.parent ? csvEscape(asset.parent->name) : "") << ",active," << (asset.type == "device" ? "P2" : "P1");
+
+        for (unsigned i = 0; i < opt.inputs; ++i) {
+            if (i < asset.powers.size()) {
+                const auto& power = asset.powers[i];
+                out << "," << csvEscape(power.source->name) << "," << power.outlet << "," << power.input;
+            } else {
+                out << ",,,";
+            }
+        }
+
+        for (const auto& [key, used] : ext) {
+            out << ",";
+            if (auto it = asset.ext.find(key); it != asset.ext.end()) {
+                out << csvEscape(it->second);
+            }
+        }
+        out << "\n";
+    }
+}
+
+// =========================================================================================================================================
+
+std::string sqlEscape(const std::string& value)
+{
+    std::string ret = "'";
+    for (char ch : value) {
+        if (ch == '\'' || ch == '\\') {
+            ret += '\\';
+        }
+        ret += ch;
+    }
+    return ret + "'";
+}
+
+void writeSql(std::ostream& out, const std::deque<Asset>& assets)
+{
+    static const size_t Batch = 1000;
+
+    out << "-- Synthetic inventory, ids from " << (assets.empty() ? 0 : assets.front().id) << "\n";
+    out << "START TRANSACTION;\n";
+    out << "SET @dev_none = (SELECT id_asset_device_type FROM t_bios_asset_device_type WHERE name = 'N_A');\n";
+    out << "SET @link_power = (SELECT id_asset_link_type FROM t_bios_asset_link_type WHERE name = 'power chain');\n";
+    for (const auto& type : {"datacenter", "room", "row", "rack", "device"}) {
+        out << "SET @type_" << type << " = (SELECT id_asset_element_type FROM t_bios_asset_element_type WHERE name = '" << type
+            << "');\n";
+    }
+    for (const auto& sub : {"feed", "ups", "epdu", "server"}) {
+        out << "SET @dev_" << sub << " = (SELECT id_asset_device_type FROM t_bios_asset_device_type WHERE name = '" << sub
+            << "');\n";
+    }
+
+    auto batches = [&](const std::string& insert, auto&& rows) {
+        size_t count = 0;
+        rows([&](const std::string& values) {
+            out << (count % Batch ? ",\n" : (count ? ";\n" + insert : insert)) << values;
+            ++count;
+        });
+        if (count) {
+            out << ";\n";
+        }
+    };
+
+    batches("INSERT INTO t_bios_asset_element (id_asset_element, name, id_type, id_subtype, id_parent, status, priority) VALUES\n",
+        [&](auto&& row) {
+            for (const auto& asset : assets) {
+                row("(" + std::to_string(asset.id) + ", " + sqlEscape(asset.iname()) + ", @type_" + asset.type + ", " +
+                    (asset.subType.empty() ? "@dev_none" : "@dev_" + asset.subType) + ", " +
+                    (asset.parent ? std::to_string(asset.parent->id) : "NULL") + ", 'active', " +
+                    (asset.type == "device" ? "2" : "1") + ")");
+            }
+        });
+
+    batches("INSERT INTO t_bios_asset_ext_attributes (keytag, value, id_asset_element, read_only) VALUES\n", [&](auto&& row) {
+        for (const auto& asset : assets) {
+            row("('name', " + sqlEscape(asset.name) + ", " + std::to_string(asset.id) + ", 0)");
+            for (const auto& [key, value] : asset.ext) {
+                row("(" + sqlEscape(key) + ", " + sqlEscape(value) + ", " + std::to_string(asset.id) + ", 0)");
+            }
+        }
+    });
+
+    batches("INSERT INTO t_bios_asset_link (id_asset_device_src, id_asset_device_dest, id_asset_link_type, src_out, dest_in) VALUES\n",
+        [&](auto&& row) {
+            for (const auto& asset : assets) {
+                for (const auto& power : asset.powers) {
+                    row("(" + std::to_string(power.source->id) + ", " + std::to_string(asset.id) + ", @link_power, " +
+                        (power.outlet.empty() ? "NULL" : sqlEscape(power.outlet)) + ", " + sqlEscape(power.input) + ")");
+                }
+            }
+        });
+
+    out << "COMMIT;\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try {
+        Options     opt = parse(argc, argv);
+        Generator   generator(opt);
+        const auto& assets = generator.generate();
+
+        if (opt.csv.empty()) {
+            writeCsv(std::cout, assets, opt);
+        } else {
+            std::ofstream out(opt.csv);
+            if (!out) {
+                throw std::runtime_error("cannot write " + opt.csv);
+            }
+            writeCsv(out, assets, opt);
+        }
+
+        if (!opt.sql.empty()) {
+            std::ofstream out(opt.sql);
+            if (!out) {
+                throw std::runtime_error("cannot write " + opt.sql);
+            }
+            writeSql(out, assets);
+        }
+
+        std::cerr << assets.size() << " assets generated" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        usage();
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}